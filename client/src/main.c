@@ -13,6 +13,19 @@
 #include "network_protocol.h"
 #include "tank_server.h"
 #include "bullet_server.h"
+#include "sprite_batch.h"
+#include "asset_loader.h"
+#include "frame_pacer.h"
+#include "trace.h"
+#include "reliable_channel.h"
+#include "trajectory.h"
+#include "latency_probe.h"
+#include "arena.h"
+#include "snapshot_codec.h"
+#include "camera.h"
+#include "static_layer.h"
+#include "clock_sync.h"
+#include "async_log.h"
 
 #ifdef _WIN32
 #include <SDL2/SDL_main.h>
@@ -27,8 +40,14 @@
 #define MAXTANKS 4
 #define SPEED 100
 #define SERVER_PORT 12345
-#define MAX_PLAYERS 4
-#define MAX_BULLETS_PER_PLAYER 5
+#define CONNECT_TIMEOUT_MS 3000
+#define MATCH_ARENA_SIZE (16 * 1024)
+#define SPRITE_CULL_MARGIN 16
+#define DEFAULT_PROBE_SAMPLES 100
+#define INPUT_KEEPALIVE_MS 250
+#define MENU_IDLE_TIMEOUT_MS 500
+#define SELECT_ANIMATION_MS 33
+#define SPECTATE_KEEPALIVE_MS 1000
 volatile int connectedPlayers = 1;
 
 typedef enum {
@@ -37,65 +56,167 @@ typedef enum {
    DIALOG_RESULT_CANCEL
 } DialogResult;
 
+typedef enum {
+    MENU_BG,
+    MENU_BTN_PRACTICE,
+    MENU_BTN_CONNECT,
+    MENU_BTN_SELECT_TANK,
+    MENU_BTN_EXIT,
+    MENU_TEXTURE_COUNT
+} MenuTexture;
+
+static const char* menuTexturePaths[MENU_TEXTURE_COUNT] = {
+    "../lib/resources/menu_bg.png",
+    "../lib/resources/btn_practice.png",
+    "../lib/resources/btn_connect.png",
+    "../lib/resources/btn_select_tank.png",
+    "../lib/resources/btn_exit.png"
+};
+
 typedef enum {
     STATE_MENU,
     STATE_SINGLE_PLAYER,
     STATE_RUNNING,
+    STATE_CONNECTING,
     STATE_SELECT_TANK,
+    STATE_SPECTATING,
     STATE_EXIT
 } GameState;
 
+typedef enum {
+    CONNECT_WAIT_START,
+    CONNECT_WAIT_STATE,
+    CONNECT_DONE,
+    CONNECT_FAILED
+} ConnectPhase;
+
+// Uppdateras från tangenthändelser så att även injicerade händelser (SDL_PushEvent) styr tanken
+typedef struct {
+    bool up, down, left, right, fire;
+} ClientInput;
+
 typedef struct {
     SDL_Window *pWindow;
     SDL_Renderer *pRenderer;
     SDL_Texture *pBackground;
-    SDL_Texture *pTankpicture;
+    SpriteBatch *pSprites;
+    AssetLoader *pAssets;
+    SDL_Texture *pMenuTextures[MENU_TEXTURE_COUNT];
+    SDL_Texture *pSelectBackground;
+    SDL_Texture *pTankPreviews[MAXTANKS];
+    int spriteJobs[SPRITE_COUNT];
+    int selectBackgroundJob;
+    int backgroundJob;
+    int fontJob;
+    bool assetsLoaded;
     SDL_Event event;
     float angle;
     Timer timer;
+    FramePacer pacer;
+    bool vsync;
+    const char* traceFile;
+    const char* probeAddress;
+    int probeSamples;
+    const char* spectateAddress;
+    Uint32 spectateCookie;
+    Uint32 lastSpectateSent;
+    bool spectateInfoReceived;
+    int spectateDelay;
+    int spectateTarget;
+    LatencyProbe* pProbe;
+    ClientInput input;
     Tank* tank;
-    Bullet bullets[MAX_BULLETS];
+    Bullet bullets[MAX_ROOM_BULLETS];
     UDPsocket pSocket;
     IPaddress serverAddress;
     UDPpacket *pPacket;
+    ReliableChannel control;
+    bool startReceived;
+    ConnectPhase connectPhase;
+    Uint32 connectStart;
+    bool connectTimedOut;
+    Uint16 snapshotAck;
+    Uint32 snapshotAckBits;
+    Uint16 sentSnapshotAck;
+    InputFrame inputFrames[INPUT_HISTORY];
+    int numInputFrames;
+    Uint16 inputSequence;
+    Uint32 lastInputSent;
+    ClockSync clock;
+    Uint32 snapshotServerTime;
+    Uint32 snapshotParts;
+    int numSnapshotBullets;
+    bool hasSnapshot;
     int playerNumber;
     int tankColorId;
     int bulletstopper;
     int lastshottime;
     char ipAddress[64];
+    Arena* pMatchArena;
+    int worldWidth;
+    int worldHeight;
+    Camera camera;
+    StaticLayer* pStaticLayer;
+    bool staticLayerDirty;
     Wall* topLeft;
     Wall* topRight;
     Wall* bottomLeft;
     Wall* bottomRight;
+    TrajectorySolver* pAimSolver;
+    bool aimPreview;
     GameState state;
     TankState otherTanks[MAX_PLAYERS];
-    SDL_Texture* tankTextures[MAXTANKS];
     int numOtherTanks;
-    bool matchOver;
-    int winningPlayerID; 
+    RoomPhase roomPhase;
+    int round;
+    int winningPlayerID;
+    Uint32 phaseEndsAt;
 } Game;
 
 
-void initiate(Game* game);
-bool connectToServer(Game* game, const char* ip, bool *timedOut);
+void initiate(Game* game, int argc, char* argv[]);
+void parseArguments(Game* game, int argc, char* argv[]);
+void finishLoadingAssets(Game* game);
+bool openServerSocket(Game* game, const char* ip);
+bool beginConnect(Game* game, const char* ip);
+bool beginSpectate(Game* game, const char* ip);
+void sendSpectateRequest(Game* game, Uint32 now);
+void updateConnect(Game* game);
+void closeConnection(Game* game);
+void resetMatch(Game* game);
+bool buildMatchWalls(Game* game);
+void prepareStaticLayer(Game* game);
+void renderStaticScene(Game* game);
+void renderBackground(Game* game);
+void renderWorldWall(Game* game, Wall* wall);
 void run(Game* game);
 void runMainMenu(Game* game);
 void enterServerIp(Game* game);
 void selectTank(Game* game);
-void loadSelectedTankTexture(Game* game);
 void runSinglePlayer(Game *game);
+void renderAimPreview(Game* game, float x, float y, float angle);
+void runConnecting(Game* game);
+void runSpectator(Game* game);
+const TankState* findSpectateTarget(Game* game, int step);
 void closeGame(Game* game);
-void showYouDiedDialog(Game* game);
-bool connectToServer(Game* game, const char* ip, bool *timedOut);
 void receiveGameState(Game* game);
+void applySnapshotPart(Game* game, const SnapshotPart* part);
+void handleControlPacket(Game* game);
+bool acceptSnapshot(Game* game, Uint16 sequence);
+void handleControlMessage(Game* game, const Uint8* message, int len);
 void sendClientUpdate(Game* game);
+void sendClockPing(Game* game, Uint32 now);
+void renderNetOverlay(Game* game);
+void handleInputEvent(Game* game, const SDL_Event* event);
+void injectProbeKey(Game* game, Uint32 type);
+void updateLatencyProbe(Game* game);
 DialogResult showErrorDialog(Game* game, const char* title, const char* message);
-void showWinnerDialog(Game* game, int winnerID);
+void renderRoomOverlay(Game* game);
 
 
 int main(int argv, char* args[]) {
    Game game;
-   initiate(&game);
+   initiate(&game, argv, args);
 
    while (game.state != STATE_EXIT) {
        switch (game.state) {
@@ -108,9 +229,15 @@ int main(int argv, char* args[]) {
         case STATE_RUNNING:
                run(&game);
                break;
+        case STATE_CONNECTING:
+               runConnecting(&game);
+               break;
         case STATE_SELECT_TANK:
                selectTank(&game);
                break;
+        case STATE_SPECTATING:
+               runSpectator(&game);
+               break;
            default:
                game.state = STATE_EXIT;
                break;
@@ -121,10 +248,16 @@ int main(int argv, char* args[]) {
 }
 
 
-void initiate(Game *game){
+void initiate(Game *game, int argc, char* argv[]){
 
     memset(game, 0, sizeof(Game));
+    parseArguments(game, argc, argv);
+    TRACE_THREAD_NAME("main");
+    if (game->probeAddress) {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    }
     SDL_Init(SDL_INIT_VIDEO);
+    startAsyncLog();
     IMG_Init(IMG_INIT_PNG);
     TTF_Init();
     if (SDLNet_Init() == -1) {
@@ -132,15 +265,33 @@ void initiate(Game *game){
             game->state = STATE_EXIT;
         }
     game->pWindow = SDL_CreateWindow("Ricochet Tank", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN);
-    game->pRenderer = SDL_CreateRenderer(game->pWindow, -1, SDL_RENDERER_ACCELERATED);
-    initTank(game->pRenderer);
-    loadHeartTexture(game->pRenderer);
-    loadBulletTexture(game->pRenderer);
-    initTextSystem("../lib/resources/Orbitron-Bold.ttf", 32);
-    SDL_Surface *bgSurface = IMG_Load("../lib/resources/background.png");
-    game->pBackground = SDL_CreateTextureFromSurface(game->pRenderer, bgSurface);
-    SDL_FreeSurface(bgSurface);
+    Uint32 rendererFlags = SDL_RENDERER_ACCELERATED;
+    if (game->vsync) rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+    if (game->probeAddress) rendererFlags = SDL_RENDERER_SOFTWARE;
+    game->pRenderer = SDL_CreateRenderer(game->pWindow, -1, rendererFlags);
+    Uint64 loadStart = SDL_GetPerformanceCounter();
+    int workers = SDL_GetCPUCount() - 1;
+    if (workers > 4) workers = 4;
+    game->pAssets = createAssetLoader(workers);
+    int menuJobs[MENU_TEXTURE_COUNT];
+    for (int i = 0; i < MENU_TEXTURE_COUNT; i++) {
+        menuJobs[i] = queueImageAsset(game->pAssets, menuTexturePaths[i]);
+    }
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        game->spriteJobs[i] = queueImageAsset(game->pAssets, getSpritePath(i));
+    }
+    game->selectBackgroundJob = queueImageAsset(game->pAssets, "../lib/resources/selTankBg.png");
+    game->backgroundJob = queueImageAsset(game->pAssets, "../lib/resources/background.png");
+    game->fontJob = queueFileAsset(game->pAssets, "../lib/resources/Orbitron-Bold.ttf");
+    for (int i = 0; i < MENU_TEXTURE_COUNT; i++) {
+        SDL_Surface* surface = game->pAssets ? takeImageAsset(game->pAssets, menuJobs[i]) : IMG_Load(menuTexturePaths[i]);
+        if (!surface) continue;
+        game->pMenuTextures[i] = SDL_CreateTextureFromSurface(game->pRenderer, surface);
+        SDL_FreeSurface(surface);
+    }
+    SDL_Log("Menu assets ready after %.1f ms", (SDL_GetPerformanceCounter() - loadStart) * 1000.0 / SDL_GetPerformanceFrequency());
     initiate_timer(&game->timer);
+    initFramePacer(&game->pacer, 60, game->vsync);
     game->state = STATE_MENU;
     game->pPacket = NULL;
     game->pSocket = NULL;
@@ -150,19 +301,110 @@ void initiate(Game *game){
     game->topRight = NULL;
     game->bottomLeft = NULL;
     game->bottomRight = NULL;
-    game->matchOver = false; 
-    game->winningPlayerID = -1; 
+    game->worldWidth = WINDOW_WIDTH;
+    game->worldHeight = WINDOW_HEIGHT;
+    game->pMatchArena = createArena(MATCH_ARENA_SIZE);
+    if (!game->pMatchArena) {
+        game->state = STATE_EXIT;
+        return;
+    }
+    game->roomPhase = ROOM_LOBBY;
+    game->winningPlayerID = 0;
+    if (game->probeAddress) {
+        game->pProbe = malloc(sizeof(LatencyProbe));
+        if (!game->pProbe) {
+            game->state = STATE_EXIT;
+            return;
+        }
+        initLatencyProbe(game->pProbe, game->probeSamples ? game->probeSamples : DEFAULT_PROBE_SAMPLES);
+        strncpy(game->ipAddress, game->probeAddress, sizeof(game->ipAddress) - 1);
+        beginConnect(game, game->ipAddress);
+        game->state = STATE_CONNECTING;
+    } else if (game->spectateAddress) {
+        strncpy(game->ipAddress, game->spectateAddress, sizeof(game->ipAddress) - 1);
+        beginSpectate(game, game->ipAddress);
+        game->state = STATE_SPECTATING;
+    }
+}
+
+
+void parseArguments(Game* game, int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--vsync") == 0) {
+            game->vsync = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            game->traceFile = argv[++i];
+        } else if (strcmp(argv[i], "--latency-probe") == 0 && i + 1 < argc) {
+            game->probeAddress = argv[++i];
+        } else if (strcmp(argv[i], "--probe-samples") == 0 && i + 1 < argc) {
+            game->probeSamples = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+            game->spectateAddress = argv[++i];
+        } else {
+            SDL_Log("Unknown argument: %s", argv[i]);
+        }
+    }
+}
+
+
+// Resten av tillgångarna avkodas i bakgrunden medan menyn visas
+void finishLoadingAssets(Game* game) {
+    if (game->assetsLoaded) return;
+    Uint64 waitStart = SDL_GetPerformanceCounter();
+    SDL_Surface* sprites[SPRITE_COUNT];
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        sprites[i] = game->pAssets ? takeImageAsset(game->pAssets, game->spriteJobs[i]) : IMG_Load(getSpritePath(i));
+    }
+    game->pSprites = createSpriteBatch(game->pRenderer, sprites);
+    for (int i = 0; i < MAXTANKS; i++) {
+        SDL_Surface* tank = sprites[getTankSprite(i)];
+        if (tank) game->pTankPreviews[i] = SDL_CreateTextureFromSurface(game->pRenderer, tank);
+    }
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        if (sprites[i]) SDL_FreeSurface(sprites[i]);
+    }
+    SDL_Surface* selectBg = game->pAssets ? takeImageAsset(game->pAssets, game->selectBackgroundJob) : IMG_Load("../lib/resources/selTankBg.png");
+    if (selectBg) {
+        game->pSelectBackground = SDL_CreateTextureFromSurface(game->pRenderer, selectBg);
+        SDL_FreeSurface(selectBg);
+    }
+    SDL_Surface* bgSurface = game->pAssets ? takeImageAsset(game->pAssets, game->backgroundJob) : IMG_Load("../lib/resources/background.png");
+    if (bgSurface) {
+        game->pBackground = SDL_CreateTextureFromSurface(game->pRenderer, bgSurface);
+        SDL_FreeSurface(bgSurface);
+    }
+    size_t fontSize = 0;
+    void* fontData = game->pAssets ? takeFileAsset(game->pAssets, game->fontJob, &fontSize) : NULL;
+    if (fontData) {
+        initTextSystemFromMemory(fontData, fontSize, 32);
+    } else {
+        initTextSystem("../lib/resources/Orbitron-Bold.ttf", 32);
+    }
+    destroyAssetLoader(game->pAssets);
+    game->pAssets = NULL;
+    game->assetsLoaded = true;
+    SDL_Log("Game assets ready, waited %.1f ms", (SDL_GetPerformanceCounter() - waitStart) * 1000.0 / SDL_GetPerformanceFrequency());
+}
+
+
+// Menyerna blockerar tills något händer; fönsterhändelser kan ha suddat ut bilden och tvingar omritning
+static bool waitMenuEvent(Game* game, int timeoutMs, bool* dirty) {
+    if (!SDL_WaitEventTimeout(&game->event, timeoutMs)) return false;
+    if (game->event.type == SDL_WINDOWEVENT || game->event.type == SDL_RENDER_TARGETS_RESET) {
+        *dirty = true;
+    }
+    return true;
 }
 
 
 void enterServerIp(Game* game) {
-    SDL_StartTextInput();
-    SDL_Texture* background = IMG_LoadTexture(game->pRenderer, "../lib/resources/selTankBg.png");
+    finishLoadingAssets(game);
+    SDL_Texture* background = game->pSelectBackground;
     if (!background) {
         SDL_Log("Failed to load background texture: %s", SDL_GetError());
-        SDL_StopTextInput();
         return;
     }
+    SDL_StartTextInput();
     char inputBuffer[64] = "";
     bool entering = true;
     int inputRectW = 450; 
@@ -170,25 +412,48 @@ void enterServerIp(Game* game) {
     int textY = 100;
     int spacing = 50; 
     SDL_Rect inputRect = {175, textY + spacing + 24, inputRectW, inputRectH}; 
-    TTF_Font* font = TTF_OpenFont("../lib/resources/Orbitron-Bold.ttf", 24);
+    TTF_Font* font = openTextFont(24);
     if (!font) {
         SDL_Log("Failed to load font: %s", TTF_GetError());
         SDL_StopTextInput();
-        SDL_DestroyTexture(background);
         return;
     }
+    bool dirty = true;
     while (entering) {
-        while (SDL_PollEvent(&game->event)) {
+        if (dirty) {
+            SDL_RenderClear(game->pRenderer); 
+            SDL_RenderCopy(game->pRenderer, background, NULL, NULL); 
+            SDL_SetRenderDrawColor(game->pRenderer, 255, 255, 255, 255); 
+            SDL_RenderDrawRect(game->pRenderer, &inputRect); 
+            SDL_Color white = {255, 255, 255, 255};
+            renderText(game->pRenderer, "Type IP And Press ENTER:", 175, 100, white);
+            if (strlen(inputBuffer) > 0) {
+                int textWidth, textHeight;
+                if (TTF_SizeText(font, inputBuffer, &textWidth, &textHeight) == 0) {
+                    int textX = inputRect.x + 10;  
+                    int textYCentered = inputRect.y + (inputRectH - textHeight) / 2; 
+                    renderText(game->pRenderer, inputBuffer, textX, textYCentered, white);
+                } else {
+                    SDL_Log("Failed to calculate text size: %s", TTF_GetError());
+                    renderText(game->pRenderer, inputBuffer, inputRect.x + 5, inputRect.y + (inputRectH - 24) / 2, white);
+                }
+            }
+            SDL_RenderPresent(game->pRenderer);
+            dirty = false;
+        }
+        if (waitMenuEvent(game, MENU_IDLE_TIMEOUT_MS, &dirty)) {
             if (game->event.type == SDL_QUIT) {
                 game->state = STATE_EXIT;
                 entering = false;
             } else if (game->event.type == SDL_TEXTINPUT) {
                 if (strlen(inputBuffer) + strlen(game->event.text.text) < 63) {
                     strcat(inputBuffer, game->event.text.text);
+                    dirty = true;
                 }
             } else if (game->event.type == SDL_KEYDOWN) {
                 if (game->event.key.keysym.sym == SDLK_BACKSPACE && strlen(inputBuffer) > 0) {
                     inputBuffer[strlen(inputBuffer) - 1] = '\0';
+                    dirty = true;
                 } else if (game->event.key.keysym.sym == SDLK_RETURN) {
                     strncpy(game->ipAddress, inputBuffer, sizeof(game->ipAddress));
                     entering = false;
@@ -197,46 +462,38 @@ void enterServerIp(Game* game) {
                 }
             }
         }
-        SDL_RenderClear(game->pRenderer); 
-        SDL_RenderCopy(game->pRenderer, background, NULL, NULL); 
-        SDL_SetRenderDrawColor(game->pRenderer, 255, 255, 255, 255); 
-        SDL_RenderDrawRect(game->pRenderer, &inputRect); 
-        SDL_Color white = {255, 255, 255, 255};
-        renderText(game->pRenderer, "Type IP And Press ENTER:", 175, 100, white);
-        if (strlen(inputBuffer) > 0) {
-            int textWidth, textHeight;
-            if (TTF_SizeText(font, inputBuffer, &textWidth, &textHeight) == 0) {
-                int textX = inputRect.x + 10;  
-                int textYCentered = inputRect.y + (inputRectH - textHeight) / 2; 
-                renderText(game->pRenderer, inputBuffer, textX, textYCentered, white);
-            } else {
-                SDL_Log("Failed to calculate text size: %s", TTF_GetError());
-                renderText(game->pRenderer, inputBuffer, inputRect.x + 5, inputRect.y + (inputRectH - 24) / 2, white);
-            }
-        }
-        SDL_RenderPresent(game->pRenderer);
-        SDL_Delay(16);
     }
     TTF_CloseFont(font);
     SDL_StopTextInput();
-    SDL_DestroyTexture(background);
 }
 
 
 void runMainMenu(Game* game) {
     bool inMenu = true;
 
-    SDL_Texture* bg = IMG_LoadTexture(game->pRenderer, "../lib/resources/menu_bg.png");
-    SDL_Texture* btnSingle = IMG_LoadTexture(game->pRenderer, "../lib/resources/btn_practice.png");
-    SDL_Texture* btnConnect = IMG_LoadTexture(game->pRenderer, "../lib/resources/btn_connect.png");
-    SDL_Texture* btnSelectTank = IMG_LoadTexture(game->pRenderer, "../lib/resources/btn_select_tank.png");
-    SDL_Texture* btnExit = IMG_LoadTexture(game->pRenderer, "../lib/resources/btn_exit.png");
+    SDL_Texture* bg = game->pMenuTextures[MENU_BG];
+    SDL_Texture* btnSingle = game->pMenuTextures[MENU_BTN_PRACTICE];
+    SDL_Texture* btnConnect = game->pMenuTextures[MENU_BTN_CONNECT];
+    SDL_Texture* btnSelectTank = game->pMenuTextures[MENU_BTN_SELECT_TANK];
+    SDL_Texture* btnExit = game->pMenuTextures[MENU_BTN_EXIT];
     SDL_Rect rectSingle = {250, 290, 300, 60};
     SDL_Rect rectConnect = {250, 370, 300, 60};
     SDL_Rect rectSelectTank = {250, 450, 300, 60};
     SDL_Rect rectExit = {250, 530, 300, 60};
+    bool dirty = true;
     while (inMenu) {
-        while (SDL_PollEvent(&game->event)) {
+        if (dirty) {
+            SDL_SetRenderDrawColor(game->pRenderer, 0, 0, 0, 255);
+            SDL_RenderClear(game->pRenderer);
+            SDL_RenderCopy(game->pRenderer, bg, NULL, NULL);
+            SDL_RenderCopy(game->pRenderer, btnSingle, NULL, &rectSingle);
+            SDL_RenderCopy(game->pRenderer, btnConnect, NULL, &rectConnect);
+            SDL_RenderCopy(game->pRenderer, btnSelectTank, NULL, &rectSelectTank);
+            SDL_RenderCopy(game->pRenderer, btnExit, NULL, &rectExit);
+            SDL_RenderPresent(game->pRenderer);
+            dirty = false;
+        }
+        if (waitMenuEvent(game, MENU_IDLE_TIMEOUT_MS, &dirty)) {
             if (game->event.type == SDL_QUIT) {
                 game->state = STATE_EXIT;
                 inMenu = false;
@@ -244,35 +501,15 @@ void runMainMenu(Game* game) {
                 int x = game->event.button.x;
                 int y = game->event.button.y;
                 if (SDL_PointInRect(&(SDL_Point){x, y}, &rectSingle)) {
-                    SDL_Delay(200);
-                    loadSelectedTankTexture(game);
                     game->state = STATE_SINGLE_PLAYER;
                     inMenu = false;
                 } else if (SDL_PointInRect(&(SDL_Point){x, y}, &rectConnect)) {
                     enterServerIp(game);
-                    bool tryConnect = true;
-                    while (tryConnect) {
-                        bool timedOut = false;
-                        if (connectToServer(game, game->ipAddress, &timedOut)) {
-                            loadSelectedTankTexture(game);
-                            game->state = STATE_RUNNING;
-                            Uint32 waitStart = SDL_GetTicks();
-                            while (!game->tank && SDL_GetTicks() - waitStart < 1000) {
-                                receiveGameState(game);
-                                SDL_Delay(10);
-                            }
-                            inMenu = false;
-                            return;
-                        } else {
-                            SDL_Log("ERROR: connectToServer() misslyckades. timedOut=%d", timedOut);
-                            DialogResult result = showErrorDialog(game, "ERROR", timedOut ? "Could not connect to server." : "Connection failed.");
-                            if (result == DIALOG_RESULT_TRY_AGAIN) {
-                                enterServerIp(game);
-                            } else {
-                                tryConnect = false;
-                            }
-                        }
+                    if (game->state != STATE_EXIT) {
+                        beginConnect(game, game->ipAddress);
+                        game->state = STATE_CONNECTING;
                     }
+                    inMenu = false;
                 } else if (SDL_PointInRect(&(SDL_Point){x, y}, &rectSelectTank)) {
                     game->state = STATE_SELECT_TANK;
                     inMenu = false;
@@ -283,26 +520,18 @@ void runMainMenu(Game* game) {
                 }
             }
         }
-        SDL_SetRenderDrawColor(game->pRenderer, 0, 0, 0, 255);
-        SDL_RenderClear(game->pRenderer);
-        SDL_RenderCopy(game->pRenderer, bg, NULL, NULL);
-        SDL_RenderCopy(game->pRenderer, btnSingle, NULL, &rectSingle);
-        SDL_RenderCopy(game->pRenderer, btnConnect, NULL, &rectConnect);
-        SDL_RenderCopy(game->pRenderer, btnSelectTank, NULL, &rectSelectTank);
-        SDL_RenderCopy(game->pRenderer, btnExit, NULL, &rectExit);
-        SDL_RenderPresent(game->pRenderer);
-        SDL_Delay(16);
     }
-    SDL_DestroyTexture(bg);
-    SDL_DestroyTexture(btnSingle);
-    SDL_DestroyTexture(btnConnect);
-    SDL_DestroyTexture(btnSelectTank);
-    SDL_DestroyTexture(btnExit);
 }
 
 
 void runSinglePlayer(Game *game) {
-    game->tank = createTank();
+    finishLoadingAssets(game);
+    resetMatch(game);
+    game->tank = createTankInArena(game->pMatchArena);
+    if (!game->tank || !buildMatchWalls(game)) {
+        game->state = STATE_MENU;
+        return;
+    }
     setTankPosition(game->tank, 400, 300);  
     setTankAngle(game->tank, 0);
     setTankColorId(game->tank, game->tankColorId);
@@ -314,13 +543,15 @@ void runSinglePlayer(Game *game) {
     float shipVelocityY = 0;
     bool closeWindow = false;
     bool up = false, down = false;
-    int thickness = 20;
-    int length = 80;
-    game->topLeft = createWall(100, 100, thickness, length, WALL_TOP_LEFT);
-    game->topRight = createWall(WINDOW_WIDTH - 100 - length, 100, thickness, length, WALL_TOP_RIGHT);
-    game->bottomLeft = createWall(100, WINDOW_HEIGHT - 100 - length, thickness, length, WALL_BOTTOM_LEFT);
-    game->bottomRight = createWall(WINDOW_WIDTH - 100 - length, WINDOW_HEIGHT - 100 - length, thickness, length, WALL_BOTTOM_RIGHT);
+    game->pAimSolver = createTrajectorySolver(WINDOW_WIDTH, WINDOW_HEIGHT, 12);
+    addTrajectoryWall(game->pAimSolver, game->topLeft);
+    addTrajectoryWall(game->pAimSolver, game->topRight);
+    addTrajectoryWall(game->pAimSolver, game->bottomLeft);
+    addTrajectoryWall(game->pAimSolver, game->bottomRight);
+    initCamera(&game->camera, WINDOW_WIDTH, WINDOW_HEIGHT, game->worldWidth, game->worldHeight);
+    prepareStaticLayer(game);
     while (!closeWindow) {
+        beginFrame(&game->pacer);
         update_timer(&game->timer);
         float dt = get_timer(&game->timer);
         while (SDL_PollEvent(&game->event)) {
@@ -329,13 +560,16 @@ void runSinglePlayer(Game *game) {
                     closeWindow = true;
                     game->state = STATE_EXIT;
                     break;
+                case SDL_RENDER_TARGETS_RESET:
+                    game->staticLayerDirty = true;
+                    break;
                 case SDL_KEYDOWN:
                     switch (game->event.key.keysym.scancode) {
                         case SDL_SCANCODE_SPACE:
                             game->bulletstopper = 0;
                             if(game->bulletstopper == 0)
                             {
-                                if(SDL_GetTicks() - game->lastshottime > 700)
+                                if(SDL_GetTicks() - game->lastshottime > FIRE_COOLDOWN_MS)
                                 {
                                     for(int i = 0;i < MAX_BULLETS;i++)
                                     {
@@ -366,6 +600,12 @@ void runSinglePlayer(Game *game) {
                         case SDL_SCANCODE_RIGHT:
                             angle += 10.0f;
                             break;
+                        case SDL_SCANCODE_F3:
+                            toggleFrameOverlay(&game->pacer);
+                            break;
+                        case SDL_SCANCODE_F4:
+                            game->aimPreview = !game->aimPreview;
+                            break;
                         default:
                             break;
                         case SDL_SCANCODE_ESCAPE:
@@ -423,15 +663,14 @@ void runSinglePlayer(Game *game) {
         if (shipY > WINDOW_HEIGHT - tankRect.h) shipY = WINDOW_HEIGHT - tankRect.h;
         setTankPosition(game->tank, shipX, shipY);
         setTankAngle(game->tank, angle);
-        SDL_RenderClear(game->pRenderer);
-        SDL_RenderCopy(game->pRenderer, game->pBackground, NULL, NULL);
-        renderWall(game->pRenderer, game->topLeft);
-        renderWall(game->pRenderer, game->topRight);
-        renderWall(game->pRenderer, game->bottomLeft);
-        renderWall(game->pRenderer, game->bottomRight);
+        endFramePhase(&game->pacer, FRAME_PHASE_UPDATE);
+        renderStaticScene(game);
         if (isTankAlive(game->tank)) {
-            drawTank(game->pRenderer, game->tank, game->pTankpicture);
-            renderTankHealth(game->pRenderer, 3);  
+            drawTank(game->pSprites, game->tank);
+            renderTankHealth(game->pSprites, 3);  
+        }
+        if (game->aimPreview) {
+            renderAimPreview(game, shipX + tankRect.w / 2, shipY + tankRect.h / 2, angle);
         }
         for (int i = 0; i < MAX_BULLETS; i++) {
             updateBullet(&game->bullets[i], dt);
@@ -461,53 +700,70 @@ void runSinglePlayer(Game *game) {
                 checkCollision(&tankRect, &bulletRect)) {
                 game->bullets[i].active = false;
             }
-            renderBullet(game->pRenderer, &game->bullets[i]);
+            renderBullet(game->pSprites, &game->bullets[i]);
         }
+        flushSpriteBatch(game->pSprites, game->pRenderer);
+        renderFrameOverlay(game->pRenderer, &game->pacer);
+        endFramePhase(&game->pacer, FRAME_PHASE_RENDER);
         SDL_RenderPresent(game->pRenderer);
-        SDL_Delay(1000 / 60);
+        endFramePhase(&game->pacer, FRAME_PHASE_PRESENT);
+        endFrame(&game->pacer);
     }
+    destroyTrajectorySolver(game->pAimSolver);
+    game->pAimSolver = NULL;
 }
 
 
-void run(Game *game) {
-    Uint32 start = SDL_GetTicks();
-    while (!game->tank && SDL_GetTicks() - start < 3000) {
-        receiveGameState(game);
-        SDL_Delay(10);
+// x/y är där fireBullet placerar kulans hörn, så linjen förskjuts till kulans mitt
+void renderAimPreview(Game* game, float x, float y, float angle) {
+    if (!game->pAimSolver) return;
+    const Trajectory* trajectory = predictTrajectory(game->pAimSolver, x, y, angle);
+    SDL_SetRenderDrawColor(game->pRenderer, 255, 220, 0, 160);
+    for (int i = 0; i < trajectory->numSegments; i++) {
+        const TrajectorySegment* segment = &trajectory->segments[i];
+        SDL_RenderDrawLineF(game->pRenderer, segment->start.x + 6, segment->start.y + 6, segment->end.x + 6, segment->end.y + 6);
     }
+}
+
+
+void run(Game *game) {
+    finishLoadingAssets(game);
     if (!game->tank) {
-        SDL_Log("ERROR: Timeout, game->tank är fortfarande NULL. Avbryter spelstart.");
+        SDL_Log("ERROR: game->tank är NULL, runConnecting borde ha väntat in första tillståndet.");
         game->state = STATE_MENU;
         return;
     }
     bool closeWindow = false;
-    bool up = false, down = false;
-    int thickness = 20;
-    int length = 80;
-    game->topLeft = createWall(100, 100, thickness, length, WALL_TOP_LEFT);
-    game->topRight = createWall(WINDOW_WIDTH - 100 - length, 100, thickness, length, WALL_TOP_RIGHT);
-    game->bottomLeft = createWall(100, WINDOW_HEIGHT - 100 - length, thickness, length, WALL_BOTTOM_LEFT);
-    game->bottomRight = createWall(WINDOW_WIDTH - 100 - length, WINDOW_HEIGHT - 100 - length, thickness, length, WALL_BOTTOM_RIGHT);
+    memset(&game->input, 0, sizeof(ClientInput));
+    if (!game->topLeft && !buildMatchWalls(game)) {
+        game->state = STATE_MENU;
+        return;
+    }
+    initCamera(&game->camera, WINDOW_WIDTH, WINDOW_HEIGHT, game->worldWidth, game->worldHeight);
+    prepareStaticLayer(game);
     while (!closeWindow) {
+        beginFrame(&game->pacer);
         update_timer(&game->timer);
+        if (game->pProbe) updateLatencyProbe(game);
         receiveGameState(game);
+        Uint32 now = SDL_GetTicks();
+        updateReliableChannel(&game->control, game->pSocket, game->pPacket, now);
+        updateClockSync(&game->clock, now);
+        if (isClockPingDue(&game->clock, now)) sendClockPing(game, now);
         float dt = get_timer(&game->timer);
-        if (game->matchOver) { 
-            showWinnerDialog(game, game->winningPlayerID);
-            game->state = STATE_MENU;
-            closeWindow = true;
-            break;
-        }
         while (SDL_PollEvent(&game->event)) {
+            handleInputEvent(game, &game->event);
             switch (game->event.type) {
                 case SDL_QUIT:
                     closeWindow = true;
                     game->state = STATE_EXIT;
                     break;
+                case SDL_RENDER_TARGETS_RESET:
+                    game->staticLayerDirty = true;
+                    break;
                 case SDL_KEYDOWN:
                     switch (game->event.key.keysym.scancode) {
-                        case SDL_SCANCODE_W: up = true; break;
-                        case SDL_SCANCODE_S: down = true; break;
+                        case SDL_SCANCODE_F3: toggleFrameOverlay(&game->pacer); break;
                         case SDL_SCANCODE_ESCAPE:
                             closeWindow = true;
                             game->state = STATE_MENU;
@@ -515,57 +771,27 @@ void run(Game *game) {
                         default: break;
                     }
                     break;
-                case SDL_KEYUP:
-                    switch (game->event.key.keysym.scancode) {
-                        case SDL_SCANCODE_W: up = false; break;
-                        case SDL_SCANCODE_S: down = false; break;
-                        default: break;
-                    }
-                    break;
             }
         }
-        if (game->tank) {
-            if (getTankHealth(game->tank) <= 0) {
-                destroyTank();
-                game->tank = NULL;
-                showYouDiedDialog(game);
-                game->state = STATE_MENU;
-                closeWindow = true;
-                break;
-            }
-            sendClientUpdate(game);
-        }
-        SDL_RenderClear(game->pRenderer);
-        SDL_RenderCopy(game->pRenderer, game->pBackground, NULL, NULL);
-        renderWall(game->pRenderer, game->topLeft);
-        renderWall(game->pRenderer, game->topRight);
-        renderWall(game->pRenderer, game->bottomLeft);
-        renderWall(game->pRenderer, game->bottomRight);
+        // Skickas även när tanken är död, annars tappar servern oss innan nästa runda
+        if (game->tank) sendClientUpdate(game);
+        endFramePhase(&game->pacer, FRAME_PHASE_UPDATE);
+        TRACE_BEGIN(renderScope, "render");
+        SDL_Rect ownRect = getTankRect(game->tank);
+        followCamera(&game->camera, ownRect.x + ownRect.w / 2.0f, ownRect.y + ownRect.h / 2.0f);
+        renderStaticScene(game);
+        setSpriteOffset(game->pSprites, game->camera.x, game->camera.y);
         for (int i = 0; i < game->numOtherTanks; i++) {
             TankState *tank = &game->otherTanks[i];
-            SDL_Rect rect = { tank->x, tank->y, 64, 64 };
-            SDL_RenderCopyEx(
-                game->pRenderer,
-                game->tankTextures[tank->tankColorId],
-                NULL, &rect,
-                tank->angle,
-                NULL,
-                SDL_FLIP_NONE
-            );
+            if (tank->health <= 0) continue;
+            SDL_FRect rect = { tank->x, tank->y, 64, 64 };
+            if (!isOnCamera(&game->camera, &rect, SPRITE_CULL_MARGIN)) continue;
+            addSprite(game->pSprites, getTankSprite(tank->tankColorId), &rect, tank->angle);
         }
-        if (game->tank) {
-            SDL_Rect rect = getTankRect(game->tank);
-            SDL_RenderCopyEx(
-                game->pRenderer,
-                game->tankTextures[getTankColorId(game->tank)],
-                NULL, &rect,
-                getTankAngle(game->tank),
-                NULL,
-                SDL_FLIP_NONE
-            );
-            renderTankHealth(game->pRenderer, getTankHealth(game->tank));
+        if (game->tank && getTankHealth(game->tank) > 0) {
+            drawTank(game->pSprites, game->tank);
         }
-        for (int i = 0; i < MAX_PLAYERS * MAX_BULLETS_PER_PLAYER; i++) {
+        for (int i = 0; i < MAX_ROOM_BULLETS; i++) {
             if (!game->bullets[i].active)
                 continue;
             SDL_Rect tankRect = getTankRect(game->tank);
@@ -588,38 +814,73 @@ void run(Game *game) {
                     game->bullets[i].velocityY *= -1;
                 }
             }
-            if (game->bullets[i].ownerId != game->playerNumber && checkCollision(&tankRect, &bulletRect)) {
+            if (game->bullets[i].ownerId != game->playerNumber && getTankHealth(game->tank) > 0 && checkCollision(&tankRect, &bulletRect)) {
                 game->bullets[i].active = false;
             }
 
-            renderBullet(game->pRenderer, &game->bullets[i]);
+            if (isOnCamera(&game->camera, &game->bullets[i].rect, 0)) {
+                renderBullet(game->pSprites, &game->bullets[i]);
+            }
         }
+        setSpriteOffset(game->pSprites, 0, 0);
+        if (getTankHealth(game->tank) > 0) {
+            renderTankHealth(game->pSprites, getTankHealth(game->tank));
+        }
+        flushSpriteBatch(game->pSprites, game->pRenderer);
+        renderRoomOverlay(game);
+        renderFrameOverlay(game->pRenderer, &game->pacer);
+        renderNetOverlay(game);
+        TRACE_END(renderScope);
+        endFramePhase(&game->pacer, FRAME_PHASE_RENDER);
+        TRACE_BEGIN(presentScope, "present");
         SDL_RenderPresent(game->pRenderer);
-        SDL_Delay(16);
+        TRACE_END(presentScope);
+        endFramePhase(&game->pacer, FRAME_PHASE_PRESENT);
+        if (game->pProbe) {
+            markProbePresented(game->pProbe, SDL_GetPerformanceCounter());
+            if (isLatencyProbeDone(game->pProbe)) {
+                reportLatencyProbe(game->pProbe);
+                game->state = STATE_EXIT;
+                closeWindow = true;
+            }
+        }
+        endFrame(&game->pacer);
     }
 }
 
 
 void selectTank(Game* game) {
+   finishLoadingAssets(game);
    bool selecting = true;
    int currentSelection = 0;
-   SDL_Texture* background = IMG_LoadTexture(game->pRenderer, "../lib/resources/selTankBg.png");
-   SDL_Texture* tanks[MAXTANKS];
+   SDL_Texture* background = game->pSelectBackground;
+   SDL_Texture** tanks = game->pTankPreviews;
    const char* tankNames[MAXTANKS] = {"Ironclad", "Blockbuster", "Ghost Walker", "Shadow Reaper"};
-   tanks[0] = IMG_LoadTexture(game->pRenderer, "../lib/resources/tank.png");
-   tanks[1] = IMG_LoadTexture(game->pRenderer, "../lib/resources/tank_lego.png");
-   tanks[2] = IMG_LoadTexture(game->pRenderer, "../lib/resources/tank_light.png");
-   tanks[3] = IMG_LoadTexture(game->pRenderer, "../lib/resources/tank_dark.png");
    SDL_Rect tankRect = {250, 150, 300, 400};
    float angle = 0.0f;
    bool swingRight = true;
    float swingSpeed = 30.0f;
    float maxSwingAngle = 5.0f;
    initiate_timer(&game->timer);
+   bool dirty = true;
+   Uint32 drawnAt = 0;
    while (selecting) {
-       update_timer(&game->timer);
-       float dt = get_timer(&game->timer);
-       while (SDL_PollEvent(&game->event)) {
+       if (dirty) {
+           SDL_RenderCopy(game->pRenderer, background, NULL, NULL);
+           SDL_Color white = {255, 255, 255, 255};
+           renderText(game->pRenderer, tankNames[currentSelection], (WINDOW_WIDTH / 2) - 100, 50, white);
+           SDL_Color gray = {180, 180, 180, 255};
+           renderText(game->pRenderer, "Press ENTER to choose", (WINDOW_WIDTH / 2) - 200, 100, gray);
+           SDL_RenderCopyEx(game->pRenderer, tanks[currentSelection], NULL, &tankRect, angle, NULL, SDL_FLIP_NONE);
+           SDL_RenderPresent(game->pRenderer);
+           drawnAt = SDL_GetTicks();
+           dirty = false;
+       }
+       // Gungningen ritas om i egen takt; minimerat fönster väntar bara på händelser
+       bool animating = !(SDL_GetWindowFlags(game->pWindow) & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN));
+       Uint32 sinceDrawn = SDL_GetTicks() - drawnAt;
+       int timeout = !animating ? MENU_IDLE_TIMEOUT_MS : sinceDrawn < SELECT_ANIMATION_MS ? (int)(SELECT_ANIMATION_MS - sinceDrawn) : 0;
+       if (waitMenuEvent(game, timeout, &dirty)) {
            if (game->event.type == SDL_QUIT) {
                game->state = STATE_EXIT;
                selecting = false;
@@ -627,9 +888,11 @@ void selectTank(Game* game) {
                switch (game->event.key.keysym.sym) {
                    case SDLK_LEFT:
                        currentSelection = (currentSelection - 1 + MAXTANKS) % MAXTANKS;
+                       dirty = true;
                        break;
                    case SDLK_RIGHT:
                        currentSelection = (currentSelection + 1) % MAXTANKS;
+                       dirty = true;
                        break;
                    case SDLK_RETURN:
                        game->tankColorId = currentSelection;
@@ -645,6 +908,8 @@ void selectTank(Game* game) {
                }
            }
        }
+       update_timer(&game->timer);
+       float dt = get_timer(&game->timer);
        if (swingRight) {
            angle += swingSpeed * dt;
            if (angle >= maxSwingAngle) {
@@ -658,30 +923,8 @@ void selectTank(Game* game) {
                swingRight = true;
            }
        }
-       SDL_RenderCopy(game->pRenderer, background, NULL, NULL);
-       SDL_Color white = {255, 255, 255, 255};
-       renderText(game->pRenderer, tankNames[currentSelection], (WINDOW_WIDTH / 2) - 100, 50, white);
-       SDL_Color gray = {180, 180, 180, 255};
-       renderText(game->pRenderer, "Press ENTER to choose", (WINDOW_WIDTH / 2) - 200, 100, gray);
-       SDL_RenderCopyEx(game->pRenderer, tanks[currentSelection], NULL, &tankRect, angle, NULL, SDL_FLIP_NONE);
-       SDL_RenderPresent(game->pRenderer);
-       SDL_Delay(16);
+       if (animating && SDL_GetTicks() - drawnAt >= SELECT_ANIMATION_MS) dirty = true;
    }
-   for (int i = 0; i < MAXTANKS; i++) {
-       SDL_DestroyTexture(tanks[i]);
-   }
-   SDL_DestroyTexture(background);
-}
-
-
-void loadSelectedTankTexture(Game* game) {
-    game->tankTextures[0] = IMG_LoadTexture(game->pRenderer, "../lib/resources/tank.png");
-    game->tankTextures[1] = IMG_LoadTexture(game->pRenderer, "../lib/resources/tank_lego.png");
-    game->tankTextures[2] = IMG_LoadTexture(game->pRenderer, "../lib/resources/tank_light.png");
-    game->tankTextures[3] = IMG_LoadTexture(game->pRenderer, "../lib/resources/tank_dark.png");
-    int id = game->tankColorId;
-    if (id < 0 || id >= MAXTANKS) id = 0;
-    game->pTankpicture = game->tankTextures[id];
 }
 
 
@@ -690,7 +933,7 @@ DialogResult showErrorDialog(Game* game, const char* title, const char* message)
         SDL_Log("ErrorDialog: Title or message is empty");
         return DIALOG_RESULT_CANCEL;
     }
-    TTF_Font* font = TTF_OpenFont("../lib/resources/Orbitron-Bold.ttf", 24);
+    TTF_Font* font = openTextFont(24);
     if (!font) {
         SDL_Log("TTF_OpenFont failed: %s", TTF_GetError());
         return DIALOG_RESULT_CANCEL;
@@ -760,8 +1003,25 @@ DialogResult showErrorDialog(Game* game, const char* title, const char* message)
     SDL_Rect cancelTextRect = {cancelRect.x + (buttonW - cancelW) / 2, cancelRect.y + (buttonH - cancelH) / 2, cancelW, cancelH};
     bool inDialog = true;
     DialogResult result = DIALOG_RESULT_NONE;
+    bool dirty = true;
     while (inDialog) {
-        while (SDL_PollEvent(&game->event)) {
+        if (dirty) {
+            SDL_SetRenderDrawColor(game->pRenderer, 50, 50, 50, 255);
+            SDL_RenderFillRect(game->pRenderer, &dialogRect);
+            SDL_SetRenderDrawColor(game->pRenderer, 100, 100, 100, 255);
+            SDL_RenderFillRect(game->pRenderer, &tryAgainRect);
+            SDL_RenderFillRect(game->pRenderer, &cancelRect);
+            SDL_SetRenderDrawColor(game->pRenderer, 255, 255, 255, 255);
+            SDL_RenderDrawRect(game->pRenderer, &tryAgainRect);
+            SDL_RenderDrawRect(game->pRenderer, &cancelRect);
+            SDL_RenderCopy(game->pRenderer, titleTexture, NULL, &titleRect);
+            SDL_RenderCopy(game->pRenderer, messageTexture, NULL, &messageRect);
+            SDL_RenderCopy(game->pRenderer, tryAgainTexture, NULL, &tryAgainTextRect);
+            SDL_RenderCopy(game->pRenderer, cancelTexture, NULL, &cancelTextRect);
+            SDL_RenderPresent(game->pRenderer);
+            dirty = false;
+        }
+        if (waitMenuEvent(game, MENU_IDLE_TIMEOUT_MS, &dirty)) {
             if (game->event.type == SDL_QUIT) {
                 game->state = STATE_EXIT;
                 inDialog = false;
@@ -778,20 +1038,6 @@ DialogResult showErrorDialog(Game* game, const char* title, const char* message)
                 }
             }
         }
-        SDL_SetRenderDrawColor(game->pRenderer, 50, 50, 50, 255);
-        SDL_RenderFillRect(game->pRenderer, &dialogRect);
-        SDL_SetRenderDrawColor(game->pRenderer, 100, 100, 100, 255);
-        SDL_RenderFillRect(game->pRenderer, &tryAgainRect);
-        SDL_RenderFillRect(game->pRenderer, &cancelRect);
-        SDL_SetRenderDrawColor(game->pRenderer, 255, 255, 255, 255);
-        SDL_RenderDrawRect(game->pRenderer, &tryAgainRect);
-        SDL_RenderDrawRect(game->pRenderer, &cancelRect);
-        SDL_RenderCopy(game->pRenderer, titleTexture, NULL, &titleRect);
-        SDL_RenderCopy(game->pRenderer, messageTexture, NULL, &messageRect);
-        SDL_RenderCopy(game->pRenderer, tryAgainTexture, NULL, &tryAgainTextRect);
-        SDL_RenderCopy(game->pRenderer, cancelTexture, NULL, &cancelTextRect);
-        SDL_RenderPresent(game->pRenderer);
-        SDL_Delay(16);
     }
     SDL_DestroyTexture(titleTexture);
     SDL_DestroyTexture(messageTexture);
@@ -802,7 +1048,8 @@ DialogResult showErrorDialog(Game* game, const char* title, const char* message)
 }
 
 
-bool connectToServer(Game* game, const char* ip, bool *timedOut) {
+// Skickar CONNECT och återvänder direkt; updateConnect driver resten från frame-loopen
+bool openServerSocket(Game* game, const char* ip) {
     IPaddress serverIP;
     if (SDLNet_ResolveHost(&serverIP, ip, SERVER_PORT) == -1) {
         SDL_Log("SDLNet_ResolveHost: %s", SDLNet_GetError());
@@ -814,358 +1061,699 @@ bool connectToServer(Game* game, const char* ip, bool *timedOut) {
         SDL_Log("SDLNet_UDP_Open: %s", SDLNet_GetError());
         return false;
     }
-    game->pPacket = SDLNet_AllocPacket(sizeof(ServerData));
+    game->pPacket = SDLNet_AllocPacket(SNAPSHOT_PART_SIZE);
     if (!game->pPacket) {
         SDL_Log("SDLNet_AllocPacket: %s", SDLNet_GetError());
         return false;
     }
+    return true;
+}
+
+
+bool beginConnect(Game* game, const char* ip) {
+    closeConnection(game);
+    game->connectPhase = CONNECT_FAILED;
+    game->connectTimedOut = false;
+    game->connectStart = SDL_GetTicks();
+    if (!openServerSocket(game, ip)) return false;
+    IPaddress serverIP = game->serverAddress;
+    initReliableChannel(&game->control, serverIP);
     ClientData request = { CONNECT };
     request.tankColorId = game->tankColorId;
-    memcpy(game->pPacket->data, &request, sizeof(ClientData));
-    game->pPacket->len = sizeof(ClientData);
-    game->pPacket->address = serverIP;
-    SDLNet_UDP_Send(game->pSocket, -1, game->pPacket);
-    Uint32 start = SDL_GetTicks();
-    *timedOut = false;
-    bool gotConnectResponse = false;
-    while (SDL_GetTicks() - start < 3000) {
-        if (SDLNet_UDP_Recv(game->pSocket, game->pPacket)) {
-            ServerCommand command;
-            memcpy(&command, game->pPacket->data, sizeof(ServerCommand));
-            if (!gotConnectResponse && game->pPacket->len == sizeof(ClientData)) {
-                ClientData response;
-                memcpy(&response, game->pPacket->data, sizeof(ClientData));
-                if (response.command == CONNECT) {
-                    game->playerNumber = response.playerNumber;
-                    SDL_Log("Connected as player %d", game->playerNumber);
-                    gotConnectResponse = true;
-                }
-            }
-            if (command == START_MATCH && game->pPacket->len == sizeof(GameInitData)) {
-                GameInitData initData;
-                memcpy(&initData, game->pPacket->data, sizeof(GameInitData));
-                game->playerNumber = initData.playerID;
-                return true;
-            }
-        }
-        SDL_Delay(10);
+    if (!sendReliable(&game->control, game->pSocket, game->pPacket, &request, sizeof(ClientData), game->connectStart)) {
+        return false;
     }
-    *timedOut = true;
-    SDL_Log("ERROR: Timeout – inget START_MATCH mottaget");
-    return false;
+    game->connectPhase = CONNECT_WAIT_START;
+    return true;
 }
 
 
-void receiveGameState(Game* game) {
-    if (SDLNet_UDP_Recv(game->pSocket, game->pPacket)) {
-        ServerCommand command;
-        memcpy(&command, game->pPacket->data, sizeof(ServerCommand));
-        if (command == GAME_STATE && game->pPacket->len == sizeof(ServerData)) {
-            ServerData serverData;
-            memcpy(&serverData, game->pPacket->data, sizeof(ServerData));
-            game->numOtherTanks = 0;
-
-            for (int i = 0; i < serverData.numPlayers; i++) {
-                if (serverData.tanks[i].playerNumber == game->playerNumber) {
-                    if (!game->tank) {
-                        game->tank = createTank();
-                        if (game->tank) {
-                            SDL_Log("INFO: Clients tank created, player number = %d", game->playerNumber);
-                        } else {
-                            SDL_Log("ERROR: createTank() returned NULL!");
-                        }
-                    }
-                    setTankPosition(game->tank, serverData.tanks[i].x, serverData.tanks[i].y);
-                    setTankAngle(game->tank, serverData.tanks[i].angle);
-                    setTankColorId(game->tank, serverData.tanks[i].tankColorId);
-                    setTankHealth(game->tank, serverData.tanks[i].health);
-                } else {
-                    game->otherTanks[game->numOtherTanks++] = serverData.tanks[i];
-                }
-            }
-            for (int i = 0; i < serverData.numBullets && i < MAX_PLAYERS * MAX_BULLETS_PER_PLAYER; i++) {
-                Bullet* b = &game->bullets[i];
-                b->rect.x = serverData.bullets[i].x;
-                b->rect.y = serverData.bullets[i].y;
-                b->rect.w = 15;
-                b->rect.h = 15;
-                b->velocityX = serverData.bullets[i].vx;
-                b->velocityY = serverData.bullets[i].vy;
-                b->active = serverData.bullets[i].active;
-                b->ownerId = serverData.bullets[i].ownerId;
-            }
-            for (int i = serverData.numBullets; i < MAX_PLAYERS * MAX_BULLETS_PER_PLAYER; i++) {
-                game->bullets[i].active = false;
-            }
-        } else if (command == MATCH_OVER && game->pPacket->len == sizeof(ServerData)) {
-            ServerData serverData;
-            memcpy(&serverData, game->pPacket->data, sizeof(ServerData));
-            game->matchOver = true;
-            game->winningPlayerID = serverData.winningPlayerID;
-            SDL_Log("Match over, winner is Player %d", game->winningPlayerID);
-        } else {
-            SDL_Log("WARN: Unknown command (command=%d, len=%d)", command, game->pPacket->len);
-        }
+void updateConnect(Game* game) {
+    if (game->connectPhase != CONNECT_WAIT_START && game->connectPhase != CONNECT_WAIT_STATE) return;
+    receiveGameState(game);
+    Uint32 now = SDL_GetTicks();
+    updateReliableChannel(&game->control, game->pSocket, game->pPacket, now);
+    if (game->connectPhase == CONNECT_WAIT_START && game->startReceived) {
+        SDL_Log("START_MATCH mottaget efter %u ms", now - game->connectStart);
+        game->connectPhase = CONNECT_WAIT_STATE;
+    }
+    if (game->connectPhase == CONNECT_WAIT_STATE && game->tank) {
+        SDL_Log("Ansluten efter %u ms", now - game->connectStart);
+        game->connectPhase = CONNECT_DONE;
+    } else if (game->control.failed || now - game->connectStart >= CONNECT_TIMEOUT_MS) {
+        SDL_Log("ERROR: Timeout – ingen anslutning efter %u ms", now - game->connectStart);
+        game->connectTimedOut = true;
+        game->connectPhase = CONNECT_FAILED;
     }
 }
 
 
-void showWinnerDialog(Game* game, int winnerID) {
-    TTF_Font* font = TTF_OpenFont("../lib/resources/Orbitron-Bold.ttf", 36); 
-    TTF_Font* smallFont = TTF_OpenFont("../lib/resources/Orbitron-Bold.ttf", 25); 
-    TTF_Font* okFont = TTF_OpenFont("../lib/resources/Orbitron-Bold.ttf", 22); 
+// Tanken och väggarna ligger i matchens arena och släpps alla på en gång
+void resetMatch(Game* game) {
+    if (game->pMatchArena) resetArena(game->pMatchArena);
+    game->worldWidth = WINDOW_WIDTH;
+    game->worldHeight = WINDOW_HEIGHT;
+    game->tank = NULL;
+    game->topLeft = NULL;
+    game->topRight = NULL;
+    game->bottomLeft = NULL;
+    game->bottomRight = NULL;
+}
 
-    if (!font || !smallFont || !okFont) {
-        SDL_Log("TTF_OpenFont failed: %s", TTF_GetError());
-        if (font) TTF_CloseFont(font);
-        if (smallFont) TTF_CloseFont(smallFont);
-        if (okFont) TTF_CloseFont(okFont);
-        return;
+
+bool buildMatchWalls(Game* game) {
+    Wall* walls[MAP_WALL_COUNT];
+    if (!createMapWalls(game->pMatchArena, game->worldWidth, game->worldHeight, walls)) return false;
+    game->topLeft = walls[0];
+    game->topRight = walls[1];
+    game->bottomLeft = walls[2];
+    game->bottomRight = walls[3];
+    return true;
+}
+
+
+// Kartan byggs om vid varje matchstart, så lagret skapas om då och ritas vid första bilden
+void prepareStaticLayer(Game* game) {
+    destroyStaticLayer(game->pStaticLayer);
+    game->pStaticLayer = createStaticLayer(game->pRenderer, game->worldWidth, game->worldHeight);
+    game->staticLayerDirty = true;
+}
+
+
+void renderStaticScene(Game* game) {
+    if (game->pStaticLayer && game->staticLayerDirty) {
+        Wall* walls[MAP_WALL_COUNT] = { game->topLeft, game->topRight, game->bottomLeft, game->bottomRight };
+        if (buildStaticLayer(game->pStaticLayer, game->pRenderer, game->pBackground, WINDOW_WIDTH, WINDOW_HEIGHT, walls, MAP_WALL_COUNT)) {
+            game->staticLayerDirty = false;
+        } else {
+            destroyStaticLayer(game->pStaticLayer);
+            game->pStaticLayer = NULL;
+        }
     }
-    char message[32];
-    snprintf(message, sizeof(message), "Player %d Wins", winnerID);
-    SDL_Color textColor = {255, 255, 255, 255};
-    SDL_Surface* messageSurface = TTF_RenderText_Solid(smallFont, message, textColor);
-    if (!messageSurface) {
-        SDL_Log("Failed to render message text: %s", TTF_GetError());
-        TTF_CloseFont(font);
-        TTF_CloseFont(smallFont);
-        TTF_CloseFont(okFont);
+    if (game->pStaticLayer) {
+        renderStaticLayer(game->pStaticLayer, game->pRenderer, (int)game->camera.x, (int)game->camera.y, WINDOW_WIDTH, WINDOW_HEIGHT);
         return;
     }
-    SDL_Texture* messageTexture = SDL_CreateTextureFromSurface(game->pRenderer, messageSurface);
-    SDL_FreeSurface(messageSurface);
-    if (!messageTexture) {
-        SDL_Log("Failed to create message texture: %s", SDL_GetError());
-        TTF_CloseFont(font);
-        TTF_CloseFont(smallFont);
-        TTF_CloseFont(okFont);
-        return;
+    SDL_RenderClear(game->pRenderer);
+    renderBackground(game);
+    renderWorldWall(game, game->topLeft);
+    renderWorldWall(game, game->topRight);
+    renderWorldWall(game, game->bottomLeft);
+    renderWorldWall(game, game->bottomRight);
+}
+
+
+// Bakgrunden upprepas över världen i fönsterstora rutor och följer med kameran
+void renderBackground(Game* game) {
+    if (!game->pBackground) return;
+    int cameraX = (int)game->camera.x;
+    int cameraY = (int)game->camera.y;
+    int startX = cameraX - ((cameraX % WINDOW_WIDTH) + WINDOW_WIDTH) % WINDOW_WIDTH;
+    int startY = cameraY - ((cameraY % WINDOW_HEIGHT) + WINDOW_HEIGHT) % WINDOW_HEIGHT;
+    for (int y = startY; y < cameraY + WINDOW_HEIGHT; y += WINDOW_HEIGHT) {
+        for (int x = startX; x < cameraX + WINDOW_WIDTH; x += WINDOW_WIDTH) {
+            SDL_Rect dst = { x - cameraX, y - cameraY, WINDOW_WIDTH, WINDOW_HEIGHT };
+            SDL_RenderCopy(game->pRenderer, game->pBackground, NULL, &dst);
+        }
     }
-    SDL_Surface* gameOverSurface = TTF_RenderText_Solid(font, "GAME OVER", textColor);
-    if (!gameOverSurface) {
-        SDL_Log("Failed to render GAME OVER text: %s", TTF_GetError());
-        SDL_DestroyTexture(messageTexture);
-        TTF_CloseFont(font);
-        TTF_CloseFont(smallFont);
-        TTF_CloseFont(okFont);
-        return;
+}
+
+
+void renderWorldWall(Game* game, Wall* wall) {
+    SDL_Rect vertical, horizontal;
+    getWallRects(wall, &vertical, &horizontal);
+    SDL_FRect verticalArea = { vertical.x, vertical.y, vertical.w, vertical.h };
+    SDL_FRect horizontalArea = { horizontal.x, horizontal.y, horizontal.w, horizontal.h };
+    if (!isOnCamera(&game->camera, &verticalArea, 0) && !isOnCamera(&game->camera, &horizontalArea, 0)) return;
+    renderWall(game->pRenderer, wall, (int)game->camera.x, (int)game->camera.y);
+}
+
+
+void closeConnection(Game* game) {
+    if (game->pPacket != NULL) {
+        SDLNet_FreePacket(game->pPacket);
+        game->pPacket = NULL;
     }
-    SDL_Texture* gameOverTexture = SDL_CreateTextureFromSurface(game->pRenderer, gameOverSurface);
-    SDL_FreeSurface(gameOverSurface);
-    if (!gameOverTexture) {
-        SDL_Log("Failed to create GAME OVER texture: %s", SDL_GetError());
-        SDL_DestroyTexture(messageTexture);
-        TTF_CloseFont(font);
-        TTF_CloseFont(smallFont);
-        TTF_CloseFont(okFont);
-        return;
+    if (game->pSocket != NULL) {
+        SDLNet_UDP_Close(game->pSocket);
+        game->pSocket = NULL;
     }
-    SDL_Surface* okSurface = TTF_RenderText_Solid(okFont, "OK", textColor);
-    if (!okSurface) {
-        SDL_Log("Failed to render OK text: %s", TTF_GetError());
-        SDL_DestroyTexture(messageTexture);
-        SDL_DestroyTexture(gameOverTexture);
-        TTF_CloseFont(font);
-        TTF_CloseFont(smallFont);
-        TTF_CloseFont(okFont);
-        return;
+    resetMatch(game);
+    game->startReceived = false;
+    game->roomPhase = ROOM_LOBBY;
+    game->numOtherTanks = 0;
+    game->hasSnapshot = false;
+    game->snapshotAck = 0;
+    game->snapshotAckBits = 0;
+    game->snapshotParts = 0;
+    game->numInputFrames = 0;
+    game->spectateCookie = 0;
+    game->spectateInfoReceived = false;
+    initClockSync(&game->clock);
+}
+
+
+// Åskådare har ingen plats och ingen kontrollkanal; första frågan går utan cookie och servern svarar med en
+bool beginSpectate(Game* game, const char* ip) {
+    closeConnection(game);
+    game->connectStart = SDL_GetTicks();
+    game->spectateTarget = 0;
+    if (!openServerSocket(game, ip)) return false;
+    sendSpectateRequest(game, game->connectStart);
+    return true;
+}
+
+
+void sendSpectateRequest(Game* game, Uint32 now) {
+    if (!game->pSocket || !game->pPacket) return;
+    SpectateRequest request;
+    memset(&request, 0, sizeof(SpectateRequest));
+    request.command = SPECTATE;
+    request.cookie = game->spectateCookie;
+    memcpy(game->pPacket->data, &request, sizeof(SpectateRequest));
+    game->pPacket->len = sizeof(SpectateRequest);
+    game->pPacket->address = game->serverAddress;
+    SDLNet_UDP_Send(game->pSocket, -1, game->pPacket);
+    game->lastSpectateSent = now;
+}
+
+
+void runConnecting(Game* game) {
+    finishLoadingAssets(game);
+    SDL_Color white = {255, 255, 255, 255};
+    char line[96];
+    while (game->state == STATE_CONNECTING) {
+        beginFrame(&game->pacer);
+        while (SDL_PollEvent(&game->event)) {
+            if (game->event.type == SDL_QUIT) {
+                game->state = STATE_EXIT;
+            } else if (game->event.type == SDL_KEYDOWN && game->event.key.keysym.sym == SDLK_ESCAPE) {
+                closeConnection(game);
+                game->state = STATE_MENU;
+            }
+        }
+        if (game->state != STATE_CONNECTING) break;
+        updateConnect(game);
+        if (game->connectPhase == CONNECT_DONE) {
+            game->state = STATE_RUNNING;
+            break;
+        }
+        if (game->connectPhase == CONNECT_FAILED && game->pProbe) {
+            SDL_Log("Latency probe: kunde inte ansluta till %s", game->ipAddress);
+            game->state = STATE_EXIT;
+            break;
+        }
+        if (game->connectPhase == CONNECT_FAILED) {
+            closeConnection(game);
+            DialogResult result = showErrorDialog(game, "ERROR", game->connectTimedOut ? "Could not connect to server." : "Connection failed.");
+            if (game->state == STATE_EXIT) break;
+            if (result == DIALOG_RESULT_TRY_AGAIN) {
+                enterServerIp(game);
+                if (game->state == STATE_EXIT) break;
+                beginConnect(game, game->ipAddress);
+            } else {
+                game->state = STATE_MENU;
+                break;
+            }
+        }
+        SDL_RenderClear(game->pRenderer);
+        if (game->pSelectBackground) SDL_RenderCopy(game->pRenderer, game->pSelectBackground, NULL, NULL);
+        snprintf(line, sizeof(line), "Connecting to %s", game->ipAddress);
+        renderText(game->pRenderer, line, 175, 100, white);
+        renderText(game->pRenderer, game->connectPhase == CONNECT_WAIT_STATE ? "Joining match..." : "Waiting for server...", 175, 150, white);
+        snprintf(line, sizeof(line), "%u ms", SDL_GetTicks() - game->connectStart);
+        if (game->control.hasRttSample) {
+            snprintf(line, sizeof(line), "%u ms  (rtt %.0f ms)", SDL_GetTicks() - game->connectStart, game->control.smoothedRtt);
+        }
+        renderSmallText(game->pRenderer, line, 175, 200, white);
+        renderSmallText(game->pRenderer, "ESC to cancel", 175, 230, white);
+        SDL_RenderPresent(game->pRenderer);
+        endFrame(&game->pacer);
     }
-    SDL_Texture* okTexture = SDL_CreateTextureFromSurface(game->pRenderer, okSurface);
-    SDL_FreeSurface(okSurface);
-    if (!okTexture) {
-        SDL_Log("Failed to create OK texture: %s", SDL_GetError());
-        SDL_DestroyTexture(messageTexture);
-        SDL_DestroyTexture(gameOverTexture);
-        TTF_CloseFont(font);
-        TTF_CloseFont(smallFont);
-        TTF_CloseFont(okFont);
+}
+
+
+// Samma snapshotström som spelarna men hela rummet och utan egen tank; kameran följer en vald spelare
+void runSpectator(Game* game) {
+    finishLoadingAssets(game);
+    if (!game->pSocket) {
+        game->state = STATE_MENU;
         return;
     }
-    int dialogW = 400, dialogH = 200; 
-    SDL_Rect dialogRect = {(WINDOW_WIDTH - dialogW) / 2, (WINDOW_HEIGHT - dialogH) / 2, dialogW, dialogH};
-    int gameOverW, gameOverH;
-    SDL_QueryTexture(gameOverTexture, NULL, NULL, &gameOverW, &gameOverH);
-    SDL_Rect gameOverRect = {dialogRect.x + (dialogW - gameOverW) / 2, dialogRect.y + 20, gameOverW, gameOverH};
-    int messageW, messageH;
-    SDL_QueryTexture(messageTexture, NULL, NULL, &messageW, &messageH);
-    SDL_Rect messageRect = {dialogRect.x + (dialogW - messageW) / 2, dialogRect.y + 20 + gameOverH + 10, messageW, messageH};
-    int buttonW = 60, buttonH = 30;
-    SDL_Rect okButtonRect = {dialogRect.x + (dialogW - buttonW) / 2, dialogRect.y + dialogH - buttonH - 20, buttonW, buttonH};
-    int okW, okH;
-    SDL_QueryTexture(okTexture, NULL, NULL, &okW, &okH);
-    SDL_Rect okTextRect = {okButtonRect.x + (buttonW - okW) / 2, okButtonRect.y + (buttonH - okH) / 2, okW, okH};
-    Uint32 startTime = SDL_GetTicks();
-    bool showing = true;
-    while (showing) {
+    SDL_Color white = {255, 255, 255, 255};
+    char line[96];
+    bool closeWindow = false;
+    bool worldReady = false;
+    while (!closeWindow) {
+        beginFrame(&game->pacer);
+        receiveGameState(game);
+        Uint32 now = SDL_GetTicks();
+        if (now - game->lastSpectateSent >= SPECTATE_KEEPALIVE_MS) sendSpectateRequest(game, now);
+        updateClockSync(&game->clock, now);
+        if (game->spectateInfoReceived && isClockPingDue(&game->clock, now)) sendClockPing(game, now);
+        int step = 0;
         while (SDL_PollEvent(&game->event)) {
             if (game->event.type == SDL_QUIT) {
+                closeWindow = true;
                 game->state = STATE_EXIT;
-                showing = false;
-            } else if (game->event.type == SDL_MOUSEBUTTONDOWN) {
-                int x = game->event.button.x;
-                int y = game->event.button.y;
-                if (SDL_PointInRect(&(SDL_Point){x, y}, &okButtonRect)) {
-                    showing = false;
+            } else if (game->event.type == SDL_RENDER_TARGETS_RESET) {
+                game->staticLayerDirty = true;
+            } else if (game->event.type == SDL_KEYDOWN) {
+                switch (game->event.key.keysym.scancode) {
+                    case SDL_SCANCODE_F3: toggleFrameOverlay(&game->pacer); break;
+                    case SDL_SCANCODE_LEFT: step = -1; break;
+                    case SDL_SCANCODE_RIGHT:
+                    case SDL_SCANCODE_TAB: step = 1; break;
+                    case SDL_SCANCODE_ESCAPE:
+                        closeWindow = true;
+                        game->state = STATE_MENU;
+                        break;
+                    default: break;
                 }
             }
         }
-        SDL_SetRenderDrawColor(game->pRenderer, 50, 50, 50, 255);
-        SDL_RenderFillRect(game->pRenderer, &dialogRect);
-        SDL_SetRenderDrawColor(game->pRenderer, 255, 255, 255, 255);
-        SDL_RenderDrawRect(game->pRenderer, &dialogRect);
-        SDL_RenderCopy(game->pRenderer, gameOverTexture, NULL, &gameOverRect);
-        SDL_RenderCopy(game->pRenderer, messageTexture, NULL, &messageRect);
-        SDL_SetRenderDrawColor(game->pRenderer, 100, 100, 100, 255);
-        SDL_RenderFillRect(game->pRenderer, &okButtonRect);
-        SDL_SetRenderDrawColor(game->pRenderer, 255, 255, 255, 255);
-        SDL_RenderDrawRect(game->pRenderer, &okButtonRect);
-        SDL_RenderCopy(game->pRenderer, okTexture, NULL, &okTextRect); 
+        if (closeWindow) break;
+        if (!game->spectateInfoReceived) {
+            if (now - game->connectStart >= CONNECT_TIMEOUT_MS) {
+                SDL_Log("ERROR: Timeout – inget svar från %s efter %u ms", game->ipAddress, now - game->connectStart);
+                game->state = STATE_MENU;
+                break;
+            }
+            SDL_RenderClear(game->pRenderer);
+            if (game->pSelectBackground) SDL_RenderCopy(game->pRenderer, game->pSelectBackground, NULL, NULL);
+            snprintf(line, sizeof(line), "Spectating %s", game->ipAddress);
+            renderText(game->pRenderer, line, 175, 100, white);
+            renderText(game->pRenderer, "Waiting for server...", 175, 150, white);
+            renderSmallText(game->pRenderer, "ESC to cancel", 175, 230, white);
+            SDL_RenderPresent(game->pRenderer);
+            endFrame(&game->pacer);
+            continue;
+        }
+        if (!worldReady) {
+            if (!buildMatchWalls(game)) {
+                game->state = STATE_MENU;
+                break;
+            }
+            initCamera(&game->camera, WINDOW_WIDTH, WINDOW_HEIGHT, game->worldWidth, game->worldHeight);
+            prepareStaticLayer(game);
+            worldReady = true;
+        }
+        endFramePhase(&game->pacer, FRAME_PHASE_UPDATE);
+        TRACE_BEGIN(renderScope, "render");
+        const TankState* target = findSpectateTarget(game, step);
+        if (target) {
+            followCamera(&game->camera, target->x + 32.0f, target->y + 32.0f);
+        } else {
+            followCamera(&game->camera, game->worldWidth / 2.0f, game->worldHeight / 2.0f);
+        }
+        renderStaticScene(game);
+        setSpriteOffset(game->pSprites, game->camera.x, game->camera.y);
+        for (int i = 0; i < game->numOtherTanks; i++) {
+            TankState *tank = &game->otherTanks[i];
+            if (tank->health <= 0) continue;
+            SDL_FRect rect = { tank->x, tank->y, 64, 64 };
+            if (!isOnCamera(&game->camera, &rect, SPRITE_CULL_MARGIN)) continue;
+            addSprite(game->pSprites, getTankSprite(tank->tankColorId), &rect, tank->angle);
+        }
+        for (int i = 0; i < MAX_ROOM_BULLETS; i++) {
+            if (game->bullets[i].active && isOnCamera(&game->camera, &game->bullets[i].rect, 0)) {
+                renderBullet(game->pSprites, &game->bullets[i]);
+            }
+        }
+        setSpriteOffset(game->pSprites, 0, 0);
+        flushSpriteBatch(game->pSprites, game->pRenderer);
+        if (target) {
+            snprintf(line, sizeof(line), "Spectating Player %d", target->playerNumber);
+        } else {
+            snprintf(line, sizeof(line), "Spectating - waiting for players");
+        }
+        renderText(game->pRenderer, line, 175, 40, white);
+        if (game->spectateDelay > 0) {
+            snprintf(line, sizeof(line), "Delay %d s   LEFT/RIGHT to switch player", game->spectateDelay);
+        } else {
+            snprintf(line, sizeof(line), "LEFT/RIGHT to switch player");
+        }
+        renderSmallText(game->pRenderer, line, 175, 80, white);
+        renderFrameOverlay(game->pRenderer, &game->pacer);
+        renderNetOverlay(game);
+        TRACE_END(renderScope);
+        endFramePhase(&game->pacer, FRAME_PHASE_RENDER);
         SDL_RenderPresent(game->pRenderer);
-        SDL_Delay(16);
+        endFramePhase(&game->pacer, FRAME_PHASE_PRESENT);
+        endFrame(&game->pacer);
     }
-    SDL_DestroyTexture(messageTexture);
-    SDL_DestroyTexture(gameOverTexture);
-    SDL_DestroyTexture(okTexture);
-    TTF_CloseFont(font);
-    TTF_CloseFont(smallFont);
-    TTF_CloseFont(okFont);
+    closeConnection(game);
 }
 
-void showYouDiedDialog(Game* game) {
-    TTF_Font* font = TTF_OpenFont("../lib/resources/Orbitron-Bold.ttf", 36);
-    TTF_Font* okFont = TTF_OpenFont("../lib/resources/Orbitron-Bold.ttf", 22);
 
-    if (!font || !okFont) {
-        SDL_Log("TTF_OpenFont failed: %s", TTF_GetError());
-        if (font) TTF_CloseFont(font);
-        if (okFont) TTF_CloseFont(okFont);
-        return;
+// Behåller vald spelare så länge den lever; annars, eller när step ges, nästa levande i snapshotens ordning
+const TankState* findSpectateTarget(Game* game, int step) {
+    int current = -1;
+    for (int i = 0; i < game->numOtherTanks; i++) {
+        if (game->otherTanks[i].playerNumber == game->spectateTarget && game->otherTanks[i].health > 0) current = i;
+    }
+    if (current >= 0 && step == 0) return &game->otherTanks[current];
+    if (step == 0) step = 1;
+    int start = current >= 0 ? current : (step > 0 ? -1 : 0);
+    for (int n = 1; n <= game->numOtherTanks; n++) {
+        int i = ((start + step * n) % game->numOtherTanks + game->numOtherTanks) % game->numOtherTanks;
+        if (game->otherTanks[i].health > 0) {
+            game->spectateTarget = game->otherTanks[i].playerNumber;
+            return &game->otherTanks[i];
+        }
     }
+    return NULL;
+}
 
-    SDL_Color textColor = {255, 255, 255, 255};
 
-    SDL_Surface* diedSurface = TTF_RenderText_Solid(font, "YOU DIED", textColor);
-    SDL_Texture* diedTexture = SDL_CreateTextureFromSurface(game->pRenderer, diedSurface);
-    SDL_FreeSurface(diedSurface);
+// Uppdaterar kvittensen och avgör om snapshoten är nyare än den vi redan visar
+bool acceptSnapshot(Game* game, Uint16 sequence) {
+    if (!game->hasSnapshot) {
+        game->hasSnapshot = true;
+        game->snapshotAck = sequence;
+        game->snapshotAckBits = 0;
+        return true;
+    }
+    Uint16 ahead = sequence - game->snapshotAck;
+    if (ahead == 0) return false;
+    if ((Sint16)ahead > 0) {
+        game->snapshotAckBits = ahead < 32 ? game->snapshotAckBits << ahead : 0;
+        if (ahead <= 32) game->snapshotAckBits |= 1u << (ahead - 1);
+        game->snapshotAck = sequence;
+        return true;
+    }
+    Uint16 behind = game->snapshotAck - sequence;
+    if (behind <= 32) game->snapshotAckBits |= 1u << (behind - 1);
+    return false;
+}
 
-    SDL_Surface* okSurface = TTF_RenderText_Solid(okFont, "OK", textColor);
-    SDL_Texture* okTexture = SDL_CreateTextureFromSurface(game->pRenderer, okSurface);
-    SDL_FreeSurface(okSurface);
 
-    int dialogW = 400, dialogH = 200;
-    SDL_Rect dialogRect = { (WINDOW_WIDTH - dialogW) / 2, (WINDOW_HEIGHT - dialogH) / 2, dialogW, dialogH };
+void handleControlPacket(Game* game) {
+    handleReliablePacket(&game->control, game->pSocket, game->pPacket, SDL_GetTicks());
+    Uint8 message[MAX_CONTROL_PAYLOAD];
+    int len;
+    while ((len = receiveReliable(&game->control, message, sizeof(message))) > 0) {
+        handleControlMessage(game, message, len);
+    }
+}
 
-    int diedW, diedH;
-    SDL_QueryTexture(diedTexture, NULL, NULL, &diedW, &diedH);
-    SDL_Rect diedRect = { dialogRect.x + (dialogW - diedW) / 2, dialogRect.y + 50, diedW, diedH };
 
-    int buttonW = 60, buttonH = 30;
-    SDL_Rect okButtonRect = { dialogRect.x + (dialogW - buttonW) / 2, dialogRect.y + dialogH - buttonH - 20, buttonW, buttonH };
+// Kontrollmeddelandena har olika storlek, så längden avgör typen
+void handleControlMessage(Game* game, const Uint8* message, int len) {
+    if (len == sizeof(ClientData)) {
+        ClientData response;
+        memcpy(&response, message, sizeof(ClientData));
+        if (response.command == CONNECT) {
+            game->playerNumber = response.playerNumber;
+            SDL_Log("Connected as player %d", game->playerNumber);
+        }
+    } else if (len == sizeof(GameInitData)) {
+        GameInitData initData;
+        memcpy(&initData, message, sizeof(GameInitData));
+        if (initData.command == START_MATCH) {
+            game->playerNumber = initData.playerID;
+            game->startReceived = true;
+            if (initData.arenaWidth >= WINDOW_WIDTH && initData.arenaHeight >= WINDOW_HEIGHT &&
+                initData.arenaWidth <= 65535 && initData.arenaHeight <= 65535) {
+                game->worldWidth = initData.arenaWidth;
+                game->worldHeight = initData.arenaHeight;
+            }
+        }
+    } else if (len == sizeof(RoomStateData)) {
+        RoomStateData roomState;
+        memcpy(&roomState, message, sizeof(RoomStateData));
+        if (roomState.command == ROOM_STATE) {
+            game->roomPhase = roomState.phase;
+            game->round = roomState.round;
+            game->winningPlayerID = roomState.winningPlayerID;
+            game->phaseEndsAt = SDL_GetTicks() + roomState.remainingMs;
+            if (game->roomPhase == ROOM_RESULTS) {
+                SDL_Log("Round %d over, winner is Player %d", game->round, game->winningPlayerID);
+            }
+        }
+    }
+}
 
-    int okW, okH;
-    SDL_QueryTexture(okTexture, NULL, NULL, &okW, &okH);
-    SDL_Rect okTextRect = { okButtonRect.x + (buttonW - okW) / 2, okButtonRect.y + (buttonH - okH) / 2, okW, okH };
 
-    bool showing = true;
-    while (showing) {
-        while (SDL_PollEvent(&game->event)) {
-            if (game->event.type == SDL_QUIT) {
-                game->state = STATE_EXIT;
-                showing = false;
-            } else if (game->event.type == SDL_MOUSEBUTTONDOWN) {
-                int x = game->event.button.x;
-                int y = game->event.button.y;
-                if (SDL_PointInRect(&(SDL_Point){x, y}, &okButtonRect)) {
-                    showing = false;
+void receiveGameState(Game* game) {
+    TRACE_SCOPE("receiveGameState");
+    while (SDLNet_UDP_Recv(game->pSocket, game->pPacket)) {
+        if (isControlPacket(game->pPacket)) {
+            handleControlPacket(game);
+            continue;
+        }
+        ServerCommand command;
+        memcpy(&command, game->pPacket->data, sizeof(ServerCommand));
+        if (command == GAME_STATE) {
+            SnapshotPart part;
+            if (!decodeSnapshotPart(game->pPacket->data, game->pPacket->len, &part)) continue;
+            // Delar av samma snapshot läggs till varandra; en nyare sekvens ersätter allt
+            if (game->hasSnapshot && part.sequence == game->snapshotAck) {
+                if (game->snapshotParts & (1u << part.part)) continue;
+            } else {
+                if (!acceptSnapshot(game, part.sequence)) continue;
+                game->snapshotServerTime = part.serverTime;
+                game->snapshotParts = 0;
+                game->numOtherTanks = 0;
+                game->numSnapshotBullets = 0;
+                for (int i = 0; i < MAX_ROOM_BULLETS; i++) {
+                    game->bullets[i].active = false;
                 }
             }
+            game->snapshotParts |= 1u << part.part;
+            applySnapshotPart(game, &part);
+        } else if (command == PONG && game->pPacket->len >= (int)sizeof(PongData)) {
+            PongData pong;
+            memcpy(&pong, game->pPacket->data, sizeof(PongData));
+            bool wasSynced = game->clock.synced;
+            addClockSample(&game->clock, pong.clientTime, pong.serverTime, SDL_GetTicks());
+            if (!wasSynced && game->clock.synced) {
+                SDL_Log("Clock synced, rtt %.0f ms", game->clock.smoothedRtt);
+            }
+        } else if (command == SPECTATE_INFO && game->pPacket->len >= (int)sizeof(SpectateInfo)) {
+            SpectateInfo info;
+            memcpy(&info, game->pPacket->data, sizeof(SpectateInfo));
+            // Med ny cookie skickas frågan direkt igen, så att strömmen startar utan att vänta på nästa keepalive
+            if (info.cookie != game->spectateCookie) {
+                game->spectateCookie = info.cookie;
+                game->lastSpectateSent = SDL_GetTicks() - SPECTATE_KEEPALIVE_MS;
+            }
+            if (!game->spectateInfoReceived && info.arenaWidth >= WINDOW_WIDTH && info.arenaHeight >= WINDOW_HEIGHT) {
+                game->worldWidth = info.arenaWidth;
+                game->worldHeight = info.arenaHeight;
+                game->spectateDelay = info.delaySeconds;
+                game->spectateInfoReceived = true;
+                SDL_Log("Spectating %s, delay %d s", game->ipAddress, game->spectateDelay);
+            }
+        } else {
+            LOG_ASYNC("WARN: Unknown command (command=%d, len=%d)", command, game->pPacket->len);
         }
+    }
+}
 
-        SDL_SetRenderDrawColor(game->pRenderer, 50, 50, 50, 255);
-        SDL_RenderFillRect(game->pRenderer, &dialogRect);
-        SDL_SetRenderDrawColor(game->pRenderer, 255, 255, 255, 255);
-        SDL_RenderDrawRect(game->pRenderer, &dialogRect);
 
-        SDL_RenderCopy(game->pRenderer, diedTexture, NULL, &diedRect);
+void applySnapshotPart(Game* game, const SnapshotPart* part) {
+    for (int i = 0; i < part->numTanks; i++) {
+        const TankState* state = &part->tanks[i];
+        if (state->playerNumber == game->playerNumber) {
+            if (!game->tank) {
+                game->tank = createTankInArena(game->pMatchArena);
+                if (game->tank) {
+                    SDL_Log("INFO: Clients tank created, player number = %d", game->playerNumber);
+                } else {
+                    SDL_Log("ERROR: createTankInArena() returned NULL!");
+                    continue;
+                }
+            }
+            setTankPosition(game->tank, state->x, state->y);
+            setTankAngle(game->tank, state->angle);
+            if (game->pProbe) markProbeReceived(game->pProbe, SDL_GetPerformanceCounter(), state->angle);
+            setTankColorId(game->tank, state->tankColorId);
+            setTankHealth(game->tank, state->health);
+        } else if (game->numOtherTanks < MAX_PLAYERS) {
+            game->otherTanks[game->numOtherTanks++] = *state;
+        }
+    }
+    for (int i = 0; i < part->numBullets && game->numSnapshotBullets < MAX_ROOM_BULLETS; i++) {
+        Bullet* b = &game->bullets[game->numSnapshotBullets++];
+        b->rect.x = part->bullets[i].x;
+        b->rect.y = part->bullets[i].y;
+        b->rect.w = 15;
+        b->rect.h = 15;
+        b->velocityX = part->bullets[i].vx;
+        b->velocityY = part->bullets[i].vy;
+        b->active = part->bullets[i].active;
+        b->ownerId = part->bullets[i].ownerId;
+    }
+}
 
-        SDL_SetRenderDrawColor(game->pRenderer, 100, 100, 100, 255);
-        SDL_RenderFillRect(game->pRenderer, &okButtonRect);
-        SDL_SetRenderDrawColor(game->pRenderer, 255, 255, 255, 255);
-        SDL_RenderDrawRect(game->pRenderer, &okButtonRect);
-        SDL_RenderCopy(game->pRenderer, okTexture, NULL, &okTextRect);
 
-        SDL_RenderPresent(game->pRenderer);
-        SDL_Delay(16);
+// Rummets fas visas ovanpå spelet i stället för i modala dialoger, så att anslutningen lever kvar mellan rundorna
+void renderRoomOverlay(Game* game) {
+    SDL_Color white = {255, 255, 255, 255};
+    char line[64];
+    Sint32 remaining = (Sint32)(game->phaseEndsAt - SDL_GetTicks());
+    int seconds = remaining > 0 ? (remaining + 999) / 1000 : 0;
+    switch (game->roomPhase) {
+        case ROOM_LOBBY:
+            snprintf(line, sizeof(line), "Waiting for players...");
+            break;
+        case ROOM_COUNTDOWN:
+            snprintf(line, sizeof(line), "Round %d starts in %d", game->round + 1, seconds);
+            break;
+        case ROOM_RESULTS:
+            if (game->winningPlayerID > 0) {
+                snprintf(line, sizeof(line), "Player %d Wins - next round in %d", game->winningPlayerID, seconds);
+            } else {
+                snprintf(line, sizeof(line), "Draw - next round in %d", seconds);
+            }
+            break;
+        default:
+            if (!game->tank || getTankHealth(game->tank) > 0) return;
+            snprintf(line, sizeof(line), "YOU DIED - waiting for next round");
+            break;
     }
-
-    SDL_DestroyTexture(diedTexture);
-    SDL_DestroyTexture(okTexture);
-    TTF_CloseFont(font);
-    TTF_CloseFont(okFont);
+    renderText(game->pRenderer, line, 175, 40, white);
 }
 
 
+// Skickar bara när inmatningen ändrats eller en ny snapshot ska kvitteras, annars en keepalive då och då
 void sendClientUpdate(Game* game) {
     if (!game || !game->tank || !game->pSocket || !game->pPacket) return;
-    ClientData data;
-    memset(&data, 0, sizeof(ClientData));
-    data.command = UPDATE;
-    data.playerNumber = game->playerNumber;
-    data.tankColorId = getTankColorId(game->tank);
-    data.angle = getTankAngle(game->tank);
-    const Uint8* keys = SDL_GetKeyboardState(NULL);
-    data.up    = keys[SDL_SCANCODE_W] || keys[SDL_SCANCODE_UP];
-    data.down  = keys[SDL_SCANCODE_S] || keys[SDL_SCANCODE_DOWN];
-    data.left  = keys[SDL_SCANCODE_A] || keys[SDL_SCANCODE_LEFT];
-    data.right = keys[SDL_SCANCODE_D] || keys[SDL_SCANCODE_RIGHT];
     Uint32 now = SDL_GetTicks();
-    if (keys[SDL_SCANCODE_SPACE] && (now - game->lastshottime > 700)) {
-        data.shooting = true;
+    Uint8 buttons = 0;
+    if (game->input.up) buttons |= INPUT_UP;
+    if (game->input.down) buttons |= INPUT_DOWN;
+    if (game->input.left) buttons |= INPUT_LEFT;
+    if (game->input.right) buttons |= INPUT_RIGHT;
+    if (game->input.fire && (now - game->lastshottime > FIRE_COOLDOWN_MS)) {
+        buttons |= INPUT_FIRE;
         game->lastshottime = now;
-    } else {
-        data.shooting = false;
     }
-    memcpy(game->pPacket->data, &data, sizeof(ClientData));
-    game->pPacket->len = sizeof(ClientData);
+    float angle = getTankAngle(game->tank);
+    const InputFrame* newest = &game->inputFrames[0];
+    bool changed = game->numInputFrames == 0 || newest->buttons != buttons || newest->angle != angle;
+    if (changed) {
+        memmove(&game->inputFrames[1], &game->inputFrames[0], (INPUT_HISTORY - 1) * sizeof(InputFrame));
+        game->inputFrames[0] = (InputFrame){ ++game->inputSequence, buttons, angle };
+        if (game->numInputFrames < INPUT_HISTORY) game->numInputFrames++;
+    }
+    bool newAck = game->hasSnapshot && game->snapshotAck != game->sentSnapshotAck;
+    if (!changed && !newAck && now - game->lastInputSent < INPUT_KEEPALIVE_MS) return;
+
+    InputPacket data;
+    memset(&data, 0, sizeof(InputPacket));
+    data.command = UPDATE;
+    data.playerNumber = game->playerNumber;
+    data.snapshotAck = game->hasSnapshot ? game->snapshotAck : 0;
+    data.snapshotAckBits = game->snapshotAckBits;
+    data.numFrames = game->numInputFrames;
+    memcpy(data.frames, game->inputFrames, sizeof(data.frames));
+    memcpy(game->pPacket->data, &data, sizeof(InputPacket));
+    game->pPacket->len = sizeof(InputPacket);
     SDLNet_UDP_Send(game->pSocket, -1, game->pPacket);
+    game->sentSnapshotAck = data.snapshotAck;
+    game->lastInputSent = now;
+    if (game->pProbe && (buttons & INPUT_RIGHT)) markProbeSent(game->pProbe, SDL_GetPerformanceCounter());
 }
 
 
-void closeGame(Game *game)
-{
-    if (game->tank) {
-        destroyTankInstance(game->tank);
-        game->tank = NULL;
+void sendClockPing(Game* game, Uint32 now) {
+    if (!game->pSocket || !game->pPacket) return;
+    PingData ping = { PING, game->playerNumber, now };
+    memcpy(game->pPacket->data, &ping, sizeof(PingData));
+    game->pPacket->len = sizeof(PingData);
+    game->pPacket->address = game->serverAddress;
+    SDLNet_UDP_Send(game->pSocket, -1, game->pPacket);
+    markClockPingSent(&game->clock, now);
+}
+
+
+// Visas under F3-överlägget; snapshotens ålder räknas mot serverns klocka, inte mot när paketet kom fram
+void renderNetOverlay(Game* game) {
+    if (!game->pacer.showOverlay || !game->clock.synced) return;
+    Sint32 age = (Sint32)(getServerTime(&game->clock, SDL_GetTicks()) - game->snapshotServerTime);
+    char line[96];
+    snprintf(line, sizeof(line), "rtt %.0f ms  snapshot %d ms", game->clock.smoothedRtt, game->hasSnapshot ? age : 0);
+    renderText(game->pRenderer, line, 8, 136, (SDL_Color){255, 255, 255, 255});
+}
+
+
+void handleInputEvent(Game* game, const SDL_Event* event) {
+    if (event->type == SDL_WINDOWEVENT && event->window.event == SDL_WINDOWEVENT_FOCUS_LOST) {
+        memset(&game->input, 0, sizeof(ClientInput));
+        return;
+    }
+    if (event->type != SDL_KEYDOWN && event->type != SDL_KEYUP) return;
+    bool pressed = event->type == SDL_KEYDOWN;
+    switch (event->key.keysym.scancode) {
+        case SDL_SCANCODE_W:
+        case SDL_SCANCODE_UP: game->input.up = pressed; break;
+        case SDL_SCANCODE_S:
+        case SDL_SCANCODE_DOWN: game->input.down = pressed; break;
+        case SDL_SCANCODE_A:
+        case SDL_SCANCODE_LEFT: game->input.left = pressed; break;
+        case SDL_SCANCODE_D:
+        case SDL_SCANCODE_RIGHT: game->input.right = pressed; break;
+        case SDL_SCANCODE_SPACE: game->input.fire = pressed; break;
+        default: break;
     }
-    destroyTank();
-    destroyBulletTexture();
-    destroyHeartTexture();
-    if (game->topLeft) {
-        destroyWall(game->topLeft);
-        game->topLeft = NULL;
+}
+
+
+void injectProbeKey(Game* game, Uint32 type) {
+    SDL_Event event;
+    memset(&event, 0, sizeof(SDL_Event));
+    event.type = type;
+    event.key.state = type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+    event.key.keysym.scancode = SDL_SCANCODE_D;
+    event.key.keysym.sym = SDLK_d;
+    SDL_PushEvent(&event);
+}
+
+
+// Trycker D och mäter tills den nya vinkeln syns; tiden räknas från att händelsen läggs i kön
+void updateLatencyProbe(Game* game) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (shouldReleaseProbe(game->pProbe)) {
+        injectProbeKey(game, SDL_KEYUP);
     }
-    if (game->topRight) {
-        destroyWall(game->topRight);
-        game->topRight = NULL;
+    if (game->tank && shouldInjectProbe(game->pProbe, now)) {
+        injectProbeKey(game, SDL_KEYDOWN);
+        markProbeInjected(game->pProbe, now, getTankAngle(game->tank));
     }
-    if (game->bottomLeft) {
-        destroyWall(game->bottomLeft);
-        game->bottomLeft = NULL;
+}
+
+
+void closeGame(Game *game)
+{
+    if (game->traceFile) {
+        TRACE_WRITE(game->traceFile);
     }
-    if (game->bottomRight) {
-        destroyWall(game->bottomRight);
-        game->bottomRight = NULL;
+    resetMatch(game);
+    destroyArena(game->pMatchArena);
+    game->pMatchArena = NULL;
+    destroyStaticLayer(game->pStaticLayer);
+    game->pStaticLayer = NULL;
+    destroySpriteBatch(game->pSprites);
+    game->pSprites = NULL;
+    destroyAssetLoader(game->pAssets);
+    game->pAssets = NULL;
+    for (int i = 0; i < MENU_TEXTURE_COUNT; i++) {
+        if (game->pMenuTextures[i]) {
+            SDL_DestroyTexture(game->pMenuTextures[i]);
+            game->pMenuTextures[i] = NULL;
+        }
     }
     for (int i = 0; i < MAXTANKS; i++) {
-        if (game->tankTextures[i]) {
-            SDL_DestroyTexture(game->tankTextures[i]);
-            game->tankTextures[i] = NULL;
+        if (game->pTankPreviews[i]) {
+            SDL_DestroyTexture(game->pTankPreviews[i]);
+            game->pTankPreviews[i] = NULL;
         }
     }
-    if (game->pTankpicture != NULL) {
-        SDL_DestroyTexture(game->pTankpicture);
-        game->pTankpicture = NULL;
+    if (game->pSelectBackground != NULL) {
+        SDL_DestroyTexture(game->pSelectBackground);
+        game->pSelectBackground = NULL;
     }
     if (game->pBackground != NULL) {
         SDL_DestroyTexture(game->pBackground);
@@ -1179,15 +1767,11 @@ void closeGame(Game *game)
         SDL_DestroyWindow(game->pWindow);
         game->pWindow = NULL;
     }
-    if (game->pPacket != NULL) {
-        SDLNet_FreePacket(game->pPacket);
-        game->pPacket = NULL;
-    }
-    if (game->pSocket != NULL) {
-        SDLNet_UDP_Close(game->pSocket);
-        game->pSocket = NULL;
-    }
+    closeConnection(game);
+    free(game->pProbe);
+    game->pProbe = NULL;
     closeTextSystem();
+    stopAsyncLog();
     SDLNet_Quit();
     IMG_Quit();
     TTF_Quit();
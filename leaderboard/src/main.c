@@ -0,0 +1,151 @@
+#include <SDL.h>
+#include <SDL_net.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stats_log.h"
+
+#define MAX_ENTRIES 4096
+#define DEFAULT_TOP 10
+
+typedef enum {
+    SORT_WINS,
+    SORT_ACCURACY,
+    SORT_HITS
+} SortKey;
+
+// Spelare känns igen på adressen; med --by-session räknas även porten, dvs. varje anslutning för sig
+typedef struct {
+    IPaddress address;
+    int rounds;
+    int wins;
+    long shots;
+    long hits;
+    long damageTaken;
+    double aliveMs;
+} Entry;
+
+static Entry entries[MAX_ENTRIES];
+static int numEntries = 0;
+static SortKey sortKey = SORT_WINS;
+
+Entry* findEntry(const IPaddress* address, bool bySession);
+void addResult(const MatchResult* result, bool bySession);
+int compareEntries(const void* a, const void* b);
+double accuracy(const Entry* entry);
+
+int main(int argc, char* argv[]) {
+    const char* statsPath = NULL;
+    int top = DEFAULT_TOP;
+    int minRounds = 1;
+    bool bySession = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sort") == 0 && i + 1 < argc) {
+            const char* key = argv[++i];
+            if (strcmp(key, "wins") == 0) sortKey = SORT_WINS;
+            else if (strcmp(key, "accuracy") == 0) sortKey = SORT_ACCURACY;
+            else if (strcmp(key, "hits") == 0) sortKey = SORT_HITS;
+            else SDL_Log("Unknown sort key: %s", key);
+        } else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            top = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-rounds") == 0 && i + 1 < argc) {
+            minRounds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--by-session") == 0) {
+            bySession = true;
+        } else if (!statsPath) {
+            statsPath = argv[i];
+        } else {
+            SDL_Log("Unknown argument: %s", argv[i]);
+        }
+    }
+    if (!statsPath || top <= 0) {
+        SDL_Log("Usage: leaderboard <stats> [--sort wins|accuracy|hits] [--top N] [--min-rounds N] [--by-session]");
+        return 1;
+    }
+    StatsReader* reader = openStatsReader(statsPath);
+    if (!reader) return 1;
+    static MatchResult result;
+    int numRounds = 0;
+    while (readMatchResult(reader, &result)) {
+        addResult(&result, bySession);
+        numRounds++;
+    }
+    closeStatsReader(reader);
+
+    // Spelare med för få rundor sorteras bort innan topplistan tas fram
+    int kept = 0;
+    for (int i = 0; i < numEntries; i++) {
+        if (entries[i].rounds >= minRounds) entries[kept++] = entries[i];
+    }
+    qsort(entries, kept, sizeof(Entry), compareEntries);
+
+    printf("%d rundor, %d spelare\n", numRounds, numEntries);
+    printf("%4s  %-21s %6s %5s %6s %6s %6s %6s %9s\n",
+           "#", "Spelare", "Rundor", "Vinst", "Skott", "Träff", "Prec%", "Skada", "Liv (s)");
+    for (int i = 0; i < kept && i < top; i++) {
+        const Entry* entry = &entries[i];
+        Uint32 host = SDLNet_Read32(&entry->address.host);
+        char name[32];
+        int n = snprintf(name, sizeof(name), "%u.%u.%u.%u",
+                         (host >> 24) & 0xFF, (host >> 16) & 0xFF, (host >> 8) & 0xFF, host & 0xFF);
+        if (bySession) snprintf(name + n, sizeof(name) - n, ":%u", SDLNet_Read16(&entry->address.port));
+        printf("%4d  %-21s %6d %5d %6ld %6ld %6.1f %6ld %9.1f\n",
+               i + 1, name, entry->rounds, entry->wins, entry->shots, entry->hits,
+               accuracy(entry) * 100.0, entry->damageTaken, entry->aliveMs / entry->rounds / 1000.0);
+    }
+    return 0;
+}
+
+
+Entry* findEntry(const IPaddress* address, bool bySession) {
+    for (int i = 0; i < numEntries; i++) {
+        if (entries[i].address.host == address->host &&
+            (!bySession || entries[i].address.port == address->port)) {
+            return &entries[i];
+        }
+    }
+    if (numEntries == MAX_ENTRIES) return NULL;
+    Entry* entry = &entries[numEntries++];
+    memset(entry, 0, sizeof(Entry));
+    entry->address = *address;
+    return entry;
+}
+
+
+void addResult(const MatchResult* result, bool bySession) {
+    for (int i = 0; i < result->numPlayers; i++) {
+        const PlayerResult* player = &result->players[i];
+        Entry* entry = findEntry(&player->address, bySession);
+        if (!entry) {
+            SDL_Log("Fler än %d spelare, resten räknas inte", MAX_ENTRIES);
+            return;
+        }
+        entry->rounds++;
+        if (player->playerID == result->winningPlayerID) entry->wins++;
+        entry->shots += player->shots;
+        entry->hits += player->hits;
+        entry->damageTaken += player->damageTaken;
+        entry->aliveMs += player->aliveMs;
+    }
+}
+
+
+double accuracy(const Entry* entry) {
+    return entry->shots > 0 ? (double)entry->hits / entry->shots : 0.0;
+}
+
+
+// Fallande efter vald nyckel, lika värden avgörs av vinster och sedan antal rundor
+int compareEntries(const void* a, const void* b) {
+    const Entry* x = a;
+    const Entry* y = b;
+    double keyX = 0.0, keyY = 0.0;
+    switch (sortKey) {
+        case SORT_WINS:     keyX = x->wins;       keyY = y->wins;       break;
+        case SORT_ACCURACY: keyX = accuracy(x);   keyY = accuracy(y);   break;
+        case SORT_HITS:     keyX = x->hits;       keyY = y->hits;       break;
+    }
+    if (keyX != keyY) return keyX < keyY ? 1 : -1;
+    if (x->wins != y->wins) return y->wins - x->wins;
+    return y->rounds - x->rounds;
+}
@@ -0,0 +1,15 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct Arena Arena;
+
+// Bumpallokator: allt som allokeras frigörs på en gång med resetArena
+Arena* createArena(size_t capacity);
+void destroyArena(Arena* arena);
+void* arenaAlloc(Arena* arena, size_t size);
+void resetArena(Arena* arena);
+size_t getArenaUsed(const Arena* arena);
+
+#endif
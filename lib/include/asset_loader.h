@@ -0,0 +1,22 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <stdbool.h>
+
+#define MAX_ASSET_JOBS 32
+
+typedef struct AssetLoader AssetLoader;
+
+AssetLoader* createAssetLoader(int numWorkers);
+void destroyAssetLoader(AssetLoader* loader);
+
+// Jobben körs i köordning, så det som behövs först ska köas först
+int queueImageAsset(AssetLoader* loader, const char* path);
+int queueFileAsset(AssetLoader* loader, const char* path);
+
+SDL_Surface* takeImageAsset(AssetLoader* loader, int job);
+void* takeFileAsset(AssetLoader* loader, int job, size_t* size);
+
+#endif
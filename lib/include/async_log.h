@@ -0,0 +1,79 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+#define LOG_MAX_ARGS 6
+#define LOG_DEFAULT_PER_SECOND 10
+
+typedef enum {
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_STRING,
+    LOG_ARG_POINTER
+} LogArgType;
+
+typedef struct {
+    LogArgType type;
+    union {
+        Sint64 i;
+        Uint64 u;
+        double d;
+        const char* s;
+        const void* p;
+    } value;
+} LogArg;
+
+// En per anropsplats; räknar anrop per sekund och hur många som tystats sedan senaste utskrift
+typedef struct {
+    SDL_atomic_t window;
+    SDL_atomic_t count;
+    SDL_atomic_t suppressed;
+} LogLimit;
+
+// Flushtråden formaterar och skriver med SDL_Log. Innan den startats, och efter stopAsyncLog,
+// formateras meddelandena direkt på anropande tråd.
+bool startAsyncLog(void);
+void stopAsyncLog(void);
+// Argumenten kopieras binärt till trådens egen ring (strängar upp till en fast längd);
+// formatsträngen måste leva hela programmet, vilket en strängliteral gör
+void logWrite(LogLimit* limit, int perSecond, const char* format, int numArgs, const LogArg* args);
+
+static inline LogArg logArgInt(Sint64 v) { return (LogArg){ LOG_ARG_INT, { .i = v } }; }
+static inline LogArg logArgUint(Uint64 v) { return (LogArg){ LOG_ARG_UINT, { .u = v } }; }
+static inline LogArg logArgDouble(double v) { return (LogArg){ LOG_ARG_DOUBLE, { .d = v } }; }
+static inline LogArg logArgString(const char* v) { return (LogArg){ LOG_ARG_STRING, { .s = v } }; }
+static inline LogArg logArgPointer(const void* v) { return (LogArg){ LOG_ARG_POINTER, { .p = v } }; }
+
+#define LOG_ARG(x) _Generic((x), \
+    _Bool: logArgInt, char: logArgInt, signed char: logArgInt, short: logArgInt, \
+    int: logArgInt, long: logArgInt, long long: logArgInt, \
+    unsigned char: logArgUint, unsigned short: logArgUint, unsigned int: logArgUint, \
+    unsigned long: logArgUint, unsigned long long: logArgUint, \
+    float: logArgDouble, double: logArgDouble, \
+    char*: logArgString, const char*: logArgString, \
+    default: logArgPointer)(x)
+
+#define LOG_CONCAT_(a, b) a##b
+#define LOG_CONCAT(a, b) LOG_CONCAT_(a, b)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+#define LOG_NARGS(...) LOG_NARGS_(_, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_MAP_0()
+#define LOG_MAP_1(a) LOG_ARG(a),
+#define LOG_MAP_2(a, ...) LOG_ARG(a), LOG_MAP_1(__VA_ARGS__)
+#define LOG_MAP_3(a, ...) LOG_ARG(a), LOG_MAP_2(__VA_ARGS__)
+#define LOG_MAP_4(a, ...) LOG_ARG(a), LOG_MAP_3(__VA_ARGS__)
+#define LOG_MAP_5(a, ...) LOG_ARG(a), LOG_MAP_4(__VA_ARGS__)
+#define LOG_MAP_6(a, ...) LOG_ARG(a), LOG_MAP_5(__VA_ARGS__)
+
+// Högst perSecond meddelanden per sekund från varje anropsplats; resten räknas och nämns i nästa utskrift
+#define LOG_ASYNC_LIMIT(perSecond, format, ...) do { \
+    static LogLimit logLimit_; \
+    LogArg logArgs_[] = { LOG_CONCAT(LOG_MAP_, LOG_NARGS(__VA_ARGS__))(__VA_ARGS__) logArgInt(0) }; \
+    logWrite(&logLimit_, perSecond, format, LOG_NARGS(__VA_ARGS__), logArgs_); \
+} while (0)
+#define LOG_ASYNC(format, ...) LOG_ASYNC_LIMIT(LOG_DEFAULT_PER_SECOND, format, ##__VA_ARGS__)
+
+#endif
@@ -3,6 +3,7 @@
 #include <SDL.h>
 #include <SDL_image.h>
 #include <stdbool.h>
+#include "sprite_batch.h"
 #define BULLET_SPEED 300
 #define MAX_BULLETS 20
 
@@ -14,12 +15,10 @@ typedef struct {
     int ownerId;
 } Bullet;
 
-void loadBulletTexture(SDL_Renderer* renderer);
-void destroyBulletTexture(void);
 void initBullet(Bullet* bullet);
 void fireBullet(Bullet* bullet, float startX, float startY, float angle, int ownerId);
 void updateBullet(Bullet* bullet, float delta_time);
-void renderBullet(SDL_Renderer* renderer, Bullet* bullet);
+void renderBullet(SpriteBatch* batch, Bullet* bullet);
 bool bulletOutOfBounds(Bullet* bullet);
 
 #endif
@@ -19,7 +19,7 @@ typedef struct {
 
 void initServerBullet(ServerBullet* bullet);
 void fireServerBullet(ServerBullet* bullet, float startX, float startY, float angle, int ownerId);
-void updateServerBullet(ServerBullet* bullet, float delta_time);
-bool serverBulletOutOfBounds(ServerBullet* bullet);
+void updateServerBullet(ServerBullet* bullet, float delta_time, int worldWidth, int worldHeight);
+bool serverBulletOutOfBounds(ServerBullet* bullet, int worldWidth, int worldHeight);
 
 #endif
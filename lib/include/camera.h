@@ -0,0 +1,20 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+// x/y är världskoordinaten för vyns övre vänstra hörn
+typedef struct {
+    float x, y;
+    int viewWidth, viewHeight;
+    int worldWidth, worldHeight;
+} Camera;
+
+void initCamera(Camera* camera, int viewWidth, int viewHeight, int worldWidth, int worldHeight);
+// Centrerar vyn på punkten men går aldrig utanför världen; en värld mindre än vyn centreras
+void followCamera(Camera* camera, float x, float y);
+// margin utökar vyn åt alla håll, t.ex. för roterade sprites eller serverns intresseområde
+bool isOnCamera(const Camera* camera, const SDL_FRect* rect, float margin);
+
+#endif
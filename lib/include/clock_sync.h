@@ -0,0 +1,36 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+#define CLOCK_SYNC_SAMPLES 8
+#define CLOCK_SYNC_FAST_INTERVAL_MS 100
+#define CLOCK_SYNC_INTERVAL_MS 1000
+#define CLOCK_SYNC_SNAP_MS 250
+// Högst så här många ms justering per sekund, så att tidslinjen aldrig hoppar bakåt synligt
+#define CLOCK_SYNC_SLEW_PER_SECOND 5.0
+
+// Skattar serverns klocka ur PING/PONG; provet med lägst RTT i fönstret har minst kö i sig och väljs som mål
+typedef struct {
+    double offset[CLOCK_SYNC_SAMPLES];
+    Uint32 rtt[CLOCK_SYNC_SAMPLES];
+    int numSamples;
+    int nextSample;
+    double targetOffset;
+    double currentOffset;
+    float smoothedRtt;
+    bool synced;
+    Uint32 lastPingSent;
+    Uint32 lastUpdate;
+} ClockSync;
+
+void initClockSync(ClockSync* clock);
+bool isClockPingDue(const ClockSync* clock, Uint32 now);
+void markClockPingSent(ClockSync* clock, Uint32 now);
+void addClockSample(ClockSync* clock, Uint32 clientSent, Uint32 serverTime, Uint32 now);
+// Anropas varje frame och för currentOffset mot målet i begränsad takt
+void updateClockSync(ClockSync* clock, Uint32 now);
+Uint32 getServerTime(const ClockSync* clock, Uint32 now);
+
+#endif
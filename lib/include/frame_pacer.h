@@ -0,0 +1,38 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+#define FRAME_HISTORY 120
+
+typedef enum {
+    FRAME_PHASE_UPDATE,
+    FRAME_PHASE_RENDER,
+    FRAME_PHASE_PRESENT,
+    FRAME_PHASE_COUNT
+} FramePhase;
+
+typedef struct {
+    Uint64 frequency;
+    Uint64 frameBudget;
+    Uint64 frameStart;
+    Uint64 phaseStart;
+    Uint64 nextDeadline;
+    float phaseMs[FRAME_PHASE_COUNT];
+    float frameMs[FRAME_HISTORY];
+    int historyIndex;
+    bool vsync;
+    bool showOverlay;
+} FramePacer;
+
+void initFramePacer(FramePacer* pacer, int targetFps, bool vsync);
+void beginFrame(FramePacer* pacer);
+void endFramePhase(FramePacer* pacer, FramePhase phase);
+// Sover bara den del av budgeten som är kvar; med vsync gör SDL_RenderPresent väntan
+void endFrame(FramePacer* pacer);
+
+void toggleFrameOverlay(FramePacer* pacer);
+void renderFrameOverlay(SDL_Renderer* renderer, const FramePacer* pacer);
+
+#endif
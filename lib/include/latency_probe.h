@@ -0,0 +1,54 @@
+#ifndef LATENCY_PROBE_H
+#define LATENCY_PROBE_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+#define LATENCY_PROBE_MAX_SAMPLES 1000
+#define LATENCY_PROBE_TIMEOUT_MS 2000
+#define LATENCY_PROBE_SETTLE_MS 300
+
+typedef enum {
+    PROBE_SEGMENT_INPUT_TO_SEND,
+    PROBE_SEGMENT_NETWORK,
+    PROBE_SEGMENT_RECEIVE_TO_PRESENT,
+    PROBE_SEGMENT_TOTAL,
+    PROBE_SEGMENT_COUNT
+} ProbeSegment;
+
+typedef enum {
+    PROBE_WAITING,
+    PROBE_INJECTED,
+    PROBE_SENT,
+    PROBE_RECEIVED,
+    PROBE_DONE
+} ProbePhase;
+
+// En tangent trycks, och tiden mäts tills tankens vinkel ändras i en mottagen snapshot och den bilden visats
+typedef struct {
+    ProbePhase phase;
+    Uint64 frequency;
+    Uint64 injectedAt;
+    Uint64 sentAt;
+    Uint64 receivedAt;
+    Uint64 nextInjectAt;
+    float baselineAngle;
+    bool keyHeld;
+    int targetSamples;
+    int numSamples;
+    int timeouts;
+    float samples[PROBE_SEGMENT_COUNT][LATENCY_PROBE_MAX_SAMPLES];
+} LatencyProbe;
+
+void initLatencyProbe(LatencyProbe* probe, int targetSamples);
+bool shouldInjectProbe(LatencyProbe* probe, Uint64 now);
+void markProbeInjected(LatencyProbe* probe, Uint64 now, float baselineAngle);
+void markProbeSent(LatencyProbe* probe, Uint64 now);
+void markProbeReceived(LatencyProbe* probe, Uint64 now, float angle);
+void markProbePresented(LatencyProbe* probe, Uint64 now);
+// true en gång per prov, när tangenten ska släppas igen
+bool shouldReleaseProbe(LatencyProbe* probe);
+bool isLatencyProbeDone(const LatencyProbe* probe);
+void reportLatencyProbe(LatencyProbe* probe);
+
+#endif
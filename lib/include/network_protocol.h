@@ -1,23 +1,51 @@
 #ifndef NETWORK_PROTOCOL_H
 #define NETWORK_PROTOCOL_H
 
+#include <SDL.h>
 #include <stdbool.h>
 
-#define MAX_PLAYERS 4
-#define MAX_BULLETS 20
-#define MATCH_OVER 3
+// Övre gräns för ett rum; serverns --max-players väljer hur många platser som faktiskt används
+#define MAX_PLAYERS 64
+#define MAX_BULLETS_PER_PLAYER 5
+#define MAX_ROOM_BULLETS (MAX_PLAYERS * MAX_BULLETS_PER_PLAYER)
+#define SNAPSHOT_PART_SIZE 1200
+#define SNAPSHOT_MAX_PARTS 32
+#define ROOM_STATE 4
+#define FIRE_COOLDOWN_MS 700
+#define CONTROL_DATA 10
+#define CONTROL_ACK 11
+#define MAX_CONTROL_PAYLOAD 64
+#define INPUT_HISTORY 4
+
+// Bitar i InputFrame.buttons
+#define INPUT_UP 0x01
+#define INPUT_DOWN 0x02
+#define INPUT_LEFT 0x04
+#define INPUT_RIGHT 0x08
+#define INPUT_FIRE 0x10
 
 typedef enum {
     CONNECT,
     UPDATE,
-    HEARTBEAT
+    HEARTBEAT,
+    PING,
+    SPECTATE
 } ClientCommand;
 
 typedef enum {
     START_MATCH,
-    GAME_STATE
+    GAME_STATE,
+    PONG,
+    SPECTATE_INFO
 } ServerCommand;
 
+typedef enum {
+    ROOM_LOBBY,
+    ROOM_COUNTDOWN,
+    ROOM_PLAYING,
+    ROOM_RESULTS
+} RoomPhase;
+
 #pragma pack(push, 1)
 
 typedef struct {
@@ -29,35 +57,30 @@ typedef struct {
     int ownerId;
 } BulletState;
 
-typedef struct {
-    float x;
-    float y;
-    float angle;
-    bool connected;
-    int health;
-} PlayerState;
-
+// CONNECT och serverns svar på den, över kontrollkanalen
 typedef struct {
     ClientCommand command;
-    float x;
-    float y;
-    float angle;
-    bool fire;
-} ClientMessage;
+    int playerNumber;
+    int tankColorId;
+} ClientData;
 
+// En ny ram skapas bara när knapparna eller vinkeln ändras
 typedef struct {
-    ServerCommand command;
-    PlayerState players[MAX_PLAYERS];
-    BulletState bullets[MAX_BULLETS];
-} ServerMessage;
+    Uint16 sequence;
+    Uint8 buttons;
+    float angle;
+} InputFrame;
 
+// UPDATE bär de senaste numFrames ramarna, nyaste först, så att servern hämtar in ett tappat paket ur nästa.
+// Skickas vid ändrad inmatning eller ny snapshot-kvittens, annars som keepalive.
 typedef struct {
     ClientCommand command;
     int playerNumber;
-    int tankColorId;
-    bool up, down, left, right, shooting;
-    float angle;
-} ClientData;
+    Uint16 snapshotAck;
+    Uint32 snapshotAckBits;
+    Uint8 numFrames;
+    InputFrame frames[INPUT_HISTORY];
+} InputPacket;
 
 typedef struct {
     int playerNumber;
@@ -68,14 +91,33 @@ typedef struct {
     bool shooting;
 } TankState;
 
+// En snapshot skickas i en eller flera delar om högst SNAPSHOT_PART_SIZE bytes.
+// Varje del är headern följd av numTanks PackedTank och numBullets PackedBullet och kan avkodas för sig.
+// serverTime är serverns SDL_GetTicks för simuleringssteget som snapshoten visar.
 typedef struct {
     ServerCommand command;
-    int winningPlayerID;
-    int numPlayers;
-    TankState tanks[MAX_PLAYERS];
-    BulletState bullets[MAX_BULLETS];
-    int numBullets;
-} ServerData;
+    Uint16 sequence;
+    Uint32 serverTime;
+    Uint8 part;
+    Uint8 partCount;
+    Uint8 numTanks;
+    Uint16 numBullets;
+} SnapshotHeader;
+
+// Positioner i hela pixlar och vinkeln i 1/65536 varv
+typedef struct {
+    Uint8 playerNumber;
+    Uint16 x, y;
+    Uint16 angle;
+    Uint8 tankColorId;
+    Sint8 health;
+} PackedTank;
+
+typedef struct {
+    Uint16 x, y;
+    Sint16 vx, vy;
+    Uint8 ownerId;
+} PackedBullet;
 
 typedef struct {
     ServerCommand command;
@@ -84,6 +126,52 @@ typedef struct {
     int arenaHeight;
 } GameInitData;
 
+// Skickas vid varje fasbyte; remainingMs är tiden kvar av nedräkningen eller resultatvisningen
+typedef struct {
+    int command;
+    int phase;
+    int round;
+    int winningPlayerID;
+    Uint32 remainingMs;
+} RoomStateData;
+
+// Klockssynk utanför kontrollkanalen; ett tappat svar ersätts bara av nästa ping
+typedef struct {
+    ClientCommand command;
+    int playerNumber;
+    Uint32 clientTime;
+} PingData;
+
+typedef struct {
+    ServerCommand command;
+    Uint32 clientTime;
+    Uint32 serverTime;
+} PongData;
+
+// Åskådare skickar SPECTATE en gång i sekunden med senaste cookie från servern.
+// Strömmen startar först när cookien stämmer, så en förfalskad avsändare kan inte prenumerera åt någon annan.
+// Utfyllnaden gör att svaret aldrig är större än frågan.
+typedef struct {
+    ClientCommand command;
+    Uint32 cookie;
+    Uint8 padding[6];
+} SpectateRequest;
+
+typedef struct {
+    ServerCommand command;
+    Uint32 cookie;
+    Uint16 arenaWidth;
+    Uint16 arenaHeight;
+    Uint16 delaySeconds;
+} SpectateInfo;
+
+// Kontrollmeddelanden (CONNECT, START_MATCH, ROOM_STATE) skickas med den här headern framför
+typedef struct {
+    int command;
+    Uint16 sequence;
+    Uint16 ack;
+} ControlHeader;
+
 #pragma pack(pop)
 
 #endif
@@ -0,0 +1,28 @@
+#ifndef PACKET_CAPTURE_H
+#define PACKET_CAPTURE_H
+
+#include <SDL.h>
+#include <SDL_net.h>
+#include <stdbool.h>
+
+#define CAPTURE_MAX_PACKET 2048
+
+typedef struct PacketCapture PacketCapture;
+
+typedef struct {
+    Uint32 time;
+    IPaddress address;
+    int len;
+    Uint8 data[CAPTURE_MAX_PACKET];
+} CapturedPacket;
+
+// Filen är en header följd av poster: tid (ms sedan start), källadress, längd och datat
+PacketCapture* openCaptureWriter(const char* path, Uint32 now);
+void writeCapturedPacket(PacketCapture* capture, const UDPpacket* packet, Uint32 now);
+
+PacketCapture* openCaptureReader(const char* path);
+bool readCapturedPacket(PacketCapture* capture, CapturedPacket* out);
+
+void closeCapture(PacketCapture* capture);
+
+#endif
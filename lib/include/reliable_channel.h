@@ -0,0 +1,52 @@
+#ifndef RELIABLE_CHANNEL_H
+#define RELIABLE_CHANNEL_H
+
+#include <SDL.h>
+#include <SDL_net.h>
+#include <stdbool.h>
+#include "network_protocol.h"
+
+#define RELIABLE_WINDOW 16
+#define RELIABLE_INITIAL_RTO 200
+#define RELIABLE_MIN_RTO 50
+#define RELIABLE_MAX_RTO 2000
+#define RELIABLE_MAX_RETRIES 12
+
+typedef struct {
+    bool inUse;
+    Uint16 sequence;
+    Uint32 sentAt;
+    int retries;
+    int len;
+    Uint8 data[MAX_CONTROL_PAYLOAD];
+} ReliableMessage;
+
+typedef struct {
+    IPaddress address;
+    Uint16 nextSendSequence;
+    Uint16 nextExpectedSequence;
+    Uint16 nextDeliverSequence;
+    ReliableMessage pending[RELIABLE_WINDOW];
+    ReliableMessage received[RELIABLE_WINDOW];
+    float smoothedRtt;
+    float rttVariance;
+    Uint32 rto;
+    bool hasRttSample;
+    bool failed;
+    // Sätts av den som inte själv får skicka på socketen, t.ex. serverns simuleringstråd; annars NULL
+    void (*send)(const UDPpacket* packet);
+} ReliableChannel;
+
+void initReliableChannel(ReliableChannel* channel, IPaddress address);
+bool isControlPacket(const UDPpacket* packet);
+
+bool sendReliable(ReliableChannel* channel, UDPsocket socket, UDPpacket* packet, const void* data, int len, Uint32 now);
+// Kvitterar och buffrar ett inkommande kontrollpaket; packet återanvänds för ACK:en
+void handleReliablePacket(ReliableChannel* channel, UDPsocket socket, UDPpacket* packet, Uint32 now);
+// Nästa meddelande i ordning, eller 0 om inget väntar
+int receiveReliable(ReliableChannel* channel, void* out, int maxLen);
+void updateReliableChannel(ReliableChannel* channel, UDPsocket socket, UDPpacket* packet, Uint32 now);
+// Tidpunkt då updateReliableChannel behöver köras igen, false om inget väntar på kvittens
+bool getNextRetransmit(const ReliableChannel* channel, Uint32* deadline);
+
+#endif
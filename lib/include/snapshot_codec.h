@@ -0,0 +1,30 @@
+#ifndef SNAPSHOT_CODEC_H
+#define SNAPSHOT_CODEC_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "network_protocol.h"
+
+#define SNAPSHOT_ENTITY_SIZE ((int)(sizeof(PackedTank) > sizeof(PackedBullet) ? sizeof(PackedTank) : sizeof(PackedBullet)))
+#define SNAPSHOT_PART_ENTITIES ((SNAPSHOT_PART_SIZE - (int)sizeof(SnapshotHeader)) / SNAPSHOT_ENTITY_SIZE)
+
+typedef struct {
+    Uint16 sequence;
+    Uint32 serverTime;
+    int part;
+    int partCount;
+    int numTanks;
+    int numBullets;
+    TankState tanks[SNAPSHOT_PART_ENTITIES];
+    BulletState bullets[SNAPSHOT_PART_ENTITIES];
+} SnapshotPart;
+
+// Tankarna läggs först och kulorna fyller på, så del 0 har alltid tankarna när de ryms
+int getSnapshotPartCount(int numTanks, int numBullets);
+int getSnapshotSize(int numTanks, int numBullets);
+// Skriver del part till out (minst SNAPSHOT_PART_SIZE bytes) och returnerar längden
+int encodeSnapshotPart(Uint8* out, Uint16 sequence, Uint32 serverTime, int part, int partCount,
+                       const TankState* tanks, int numTanks, const BulletState* bullets, int numBullets);
+bool decodeSnapshotPart(const Uint8* data, int len, SnapshotPart* part);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef SNAPSHOT_CONTROL_H
+#define SNAPSHOT_CONTROL_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "token_bucket.h"
+
+#define SNAPSHOT_HISTORY 64
+#define SNAPSHOT_ACK_BITS 32
+#define SNAPSHOT_LOSS_THRESHOLD 3
+#define SNAPSHOT_MIN_INTERVAL 100
+#define SNAPSHOT_MAX_INTERVAL 400
+#define SNAPSHOT_MIN_BYTES_PER_SECOND 1500
+#define SNAPSHOT_MAX_BYTES_PER_SECOND 16000
+#define SNAPSHOT_BYTES_STEP 150
+
+typedef struct {
+    Uint16 sequence;
+    Uint32 sentAt;
+    bool sent;
+    bool acked;
+} SnapshotRecord;
+
+// Skattar RTT och förlust ur klientens kvittenser och styr takt och bytebudget med AIMD
+typedef struct {
+    SnapshotRecord history[SNAPSHOT_HISTORY];
+    Uint16 nextSequence;
+    Uint16 newestAck;
+    Uint16 lossCheckedUpTo;
+    bool hasAck;
+    float smoothedRtt;
+    float minRtt;
+    bool hasRtt;
+    float lossRate;
+    Uint32 lastDecrease;
+    Uint32 interval;
+    Uint32 lastSent;
+    float bytesPerSecond;
+    TokenBucket budget;
+} SnapshotControl;
+
+void initSnapshotControl(SnapshotControl* control, Uint32 now);
+bool isSnapshotDue(const SnapshotControl* control, Uint32 now);
+// Antal bytes som får skickas just nu
+int getSnapshotAllowance(SnapshotControl* control, Uint32 now);
+Uint16 recordSnapshotSent(SnapshotControl* control, int bytes, Uint32 now);
+// ackBits: bit i betyder att sekvens ack - 1 - i också har kommit fram
+void handleSnapshotAck(SnapshotControl* control, Uint16 ack, Uint32 ackBits, Uint32 now);
+
+#endif
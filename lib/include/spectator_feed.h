@@ -0,0 +1,30 @@
+#ifndef SPECTATOR_FEED_H
+#define SPECTATOR_FEED_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "network_protocol.h"
+#include "snapshot_codec.h"
+
+// Hela rummet ryms alltid i så här många delar
+#define SPECTATOR_FRAME_PARTS ((MAX_PLAYERS + MAX_ROOM_BULLETS + SNAPSHOT_PART_ENTITIES - 1) / SNAPSHOT_PART_ENTITIES)
+
+typedef struct SpectatorFeed SpectatorFeed;
+
+// Ring med de senast kodade snapshotarna, en skrivartråd och en läsartråd.
+// Bilderna numreras från 0; en bild som hunnit skrivas över upptäcks vid läsningen i stället för att blandas ihop.
+SpectatorFeed* createSpectatorFeed(int capacity);
+void destroySpectatorFeed(SpectatorFeed* feed);
+int getSpectatorFeedCapacity(const SpectatorFeed* feed);
+
+// Skrivaren kodar direkt in i bildens delar och publicerar sedan
+Uint8* getSpectatorPartBuffer(SpectatorFeed* feed, int part);
+void publishSpectatorFrame(SpectatorFeed* feed, const int* lengths, int numParts, Uint32 now);
+
+// Antal publicerade bilder, dvs. numret på nästa bild som skrivs
+Uint32 getSpectatorFeedHead(SpectatorFeed* feed);
+bool peekSpectatorFrame(SpectatorFeed* feed, Uint32 number, Uint32* publishedAt, int* numParts);
+// Kopierar en del till out (minst SNAPSHOT_PART_SIZE bytes); false om bilden skrevs över under tiden
+bool copySpectatorPart(SpectatorFeed* feed, Uint32 number, int part, Uint8* out, int* len);
+
+#endif
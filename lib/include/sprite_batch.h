@@ -0,0 +1,33 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <stdbool.h>
+
+typedef enum {
+    SPRITE_TANK_IRONCLAD,
+    SPRITE_TANK_BLOCKBUSTER,
+    SPRITE_TANK_GHOST_WALKER,
+    SPRITE_TANK_SHADOW_REAPER,
+    SPRITE_BULLET,
+    SPRITE_HEART,
+    SPRITE_COUNT
+} SpriteId;
+
+typedef struct SpriteBatch SpriteBatch;
+
+// Ytorna skalas in i atlasen; anroparen äger och frigör dem själv
+SpriteBatch* createSpriteBatch(SDL_Renderer* renderer, SDL_Surface* sprites[SPRITE_COUNT]);
+void destroySpriteBatch(SpriteBatch* batch);
+
+const char* getSpritePath(SpriteId id);
+SpriteId getTankSprite(int colorId);
+
+// Koordinaterna roteras på CPU:n runt dst-mitten, samma konvention som SDL_RenderCopyEx
+void addSprite(SpriteBatch* batch, SpriteId id, const SDL_FRect* dst, float angle);
+// Dras av från alla följande dst, så att anroparen kan lägga till sprites i världskoordinater
+void setSpriteOffset(SpriteBatch* batch, float x, float y);
+void flushSpriteBatch(SpriteBatch* batch, SDL_Renderer* renderer);
+
+#endif
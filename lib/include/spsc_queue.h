@@ -0,0 +1,16 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+typedef struct SpscQueue SpscQueue;
+
+// Låsfri kö med plats för capacity element av fast storlek, för exakt en producent- och en konsumenttråd
+SpscQueue* createSpscQueue(int capacity, int elementSize);
+void destroySpscQueue(SpscQueue* queue);
+// Kopierar in elementet; false när kön är full
+bool pushSpscQueue(SpscQueue* queue, const void* element);
+bool popSpscQueue(SpscQueue* queue, void* element);
+
+#endif
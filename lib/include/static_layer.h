@@ -0,0 +1,20 @@
+#ifndef STATIC_LAYER_H
+#define STATIC_LAYER_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "wall.h"
+
+typedef struct StaticLayer StaticLayer;
+
+// Bakgrund och väggar ritas en gång till en världsstor texture som sedan kopieras med en RenderCopy per bild.
+// NULL om renderaren saknar render targets eller världen är för stor; då ritar anroparen lagret själv som förut.
+StaticLayer* createStaticLayer(SDL_Renderer* renderer, int worldWidth, int worldHeight);
+void destroyStaticLayer(StaticLayer* layer);
+
+// Bakgrunden upprepas i rutor om tileWidth x tileHeight; anropas vid matchstart och när SDL tappat texturen
+bool buildStaticLayer(StaticLayer* layer, SDL_Renderer* renderer, SDL_Texture* background, int tileWidth, int tileHeight,
+                      Wall* walls[], int numWalls);
+void renderStaticLayer(StaticLayer* layer, SDL_Renderer* renderer, int cameraX, int cameraY, int viewWidth, int viewHeight);
+
+#endif
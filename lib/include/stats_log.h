@@ -0,0 +1,43 @@
+#ifndef STATS_LOG_H
+#define STATS_LOG_H
+
+#include <SDL.h>
+#include <SDL_net.h>
+#include <stdbool.h>
+#include "network_protocol.h"
+
+typedef struct {
+    IPaddress address;
+    Uint8 playerID;
+    Uint8 tankColorId;
+    Uint16 shots;
+    Uint16 hits;
+    Uint16 damageTaken;
+    Uint32 aliveMs;
+} PlayerResult;
+
+typedef struct {
+    Sint64 endedAt;
+    Uint32 round;
+    Uint32 durationMs;
+    Uint8 winningPlayerID;
+    int numPlayers;
+    PlayerResult players[MAX_PLAYERS];
+} MatchResult;
+
+typedef struct StatsWriter StatsWriter;
+typedef struct StatsReader StatsReader;
+
+// Filen är en header följd av en post per runda: rundans fält och sedan numPlayers spelarposter.
+// Skrivaren har en egen tråd som samlar ihop posterna och gör fsync med jämna mellanrum.
+StatsWriter* createStatsWriter(const char* path);
+// Kopierar bara in resultatet i en kö, så den blockerar aldrig; false när kön är full
+bool submitMatchResult(StatsWriter* writer, const MatchResult* result);
+// Skriver ut det som ligger i kön och synkar innan filen stängs
+void destroyStatsWriter(StatsWriter* writer);
+
+StatsReader* openStatsReader(const char* path);
+bool readMatchResult(StatsReader* reader, MatchResult* out);
+void closeStatsReader(StatsReader* reader);
+
+#endif
@@ -6,12 +6,16 @@
 #include <SDL_image.h>
 #include <math.h>
 #include <stdlib.h>
+#include "sprite_batch.h"
+#include "arena.h"
 
 #define SPEED 100
 
 typedef struct Tank Tank;
 
 Tank* createTank(void);
+// Frigörs när matchens arena nollställs, inte med destroyTankInstance
+Tank* createTankInArena(Arena* arena);
 void destroyTankInstance(Tank* tank);
 
 void setTankPosition(Tank* tank, int x, int y);
@@ -24,11 +28,7 @@ int getTankColorId(const Tank* tank);
 SDL_Rect getTankRect(const Tank* tank);
 float getTankAngle(const Tank* tank);
 
-void initTank(SDL_Renderer* renderer);
-void drawTank(SDL_Renderer* renderer, Tank* tank, SDL_Texture* texture);
-void loadHeartTexture(SDL_Renderer* renderer);
-void destroyHeartTexture(void);
-void renderTankHealth(SDL_Renderer* renderer, int health);
-void destroyTank(void);
+void drawTank(SpriteBatch* batch, Tank* tank);
+void renderTankHealth(SpriteBatch* batch, int health);
 
 #endif
@@ -4,6 +4,9 @@
 #include <SDL.h>
 #include <SDL_net.h>
 #include <stdbool.h>
+#include "token_bucket.h"
+#include "snapshot_control.h"
+#include "arena.h"
 
 typedef struct {
     IPaddress address;
@@ -16,11 +19,26 @@ typedef struct {
     bool active;
     bool up, down, left, right;
     float angle;
+    Uint16 lastInputSequence;
+    bool hasInput;
+    Uint32 lastShotTime;
+    TokenBucket packetBucket;
+    TokenBucket byteBucket;
+    bool throttled;
+    SnapshotControl snapshots;
+    // Statistik för pågående runda
+    bool inRound;
+    Uint16 shots;
+    Uint16 hits;
+    Uint16 damageTaken;
+    Uint32 diedAt;
 } PlayerStatus;
 
 typedef struct Tank Tank;
 
 Tank* createTank();
+// Frigörs när matchens arena nollställs, inte med destroyTankInstance
+Tank* createTankInArena(Arena* arena);
 void destroyTankInstance(Tank* tank);
 
 void setTankPosition(Tank* tank, int x, int y);
@@ -4,7 +4,10 @@
 #include <SDL_ttf.h>
 
 void initTextSystem(const char* fontPath, int fontSize);
+void initTextSystemFromMemory(void* fontData, size_t size, int fontSize);
+TTF_Font* openTextFont(int fontSize);
 void renderText(SDL_Renderer* renderer, const char* text, int x, int y, SDL_Color color);
+void renderSmallText(SDL_Renderer* renderer, const char* text, int x, int y, SDL_Color color);
 void closeTextSystem(void);
 
 #endif
\ No newline at end of file
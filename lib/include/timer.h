@@ -6,7 +6,7 @@
 #include <math.h>
 
 typedef struct {
-    Uint32 last_time;
+    Uint64 last_time;
     float delta_time;
 } Timer;
 
@@ -0,0 +1,40 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+
+typedef struct TimerEntry TimerEntry;
+typedef void (*TimerCallback)(TimerEntry* entry, Uint32 now);
+
+// Ligger inbäddad i ägarens struct, så schemaläggning allokerar aldrig
+struct TimerEntry {
+    TimerEntry* next;
+    TimerEntry* prev;
+    Uint32 expires;
+    TimerCallback callback;
+    void* userData;
+};
+
+typedef struct {
+    TimerEntry slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    Uint32 currentTick;
+    Uint32 resolution;
+} TimerWheel;
+
+void initTimerWheel(TimerWheel* wheel, Uint32 now, Uint32 resolutionMs);
+void initTimerEntry(TimerEntry* entry, TimerCallback callback, void* userData);
+
+// Tider anges i ms (SDL_GetTicks); en redan schemalagd timer flyttas
+void scheduleTimer(TimerWheel* wheel, TimerEntry* entry, Uint32 expiresAt);
+void cancelTimer(TimerEntry* entry);
+bool isTimerScheduled(const TimerEntry* entry);
+
+// Kör callbacks för alla timers som löpt ut till och med now
+void advanceTimerWheel(TimerWheel* wheel, Uint32 now);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef TOKEN_BUCKET_H
+#define TOKEN_BUCKET_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+typedef struct {
+    float tokens;
+    float capacity;
+    float refillPerSecond;
+    Uint32 lastRefill;
+} TokenBucket;
+
+void initTokenBucket(TokenBucket* bucket, float capacity, float refillPerSecond, Uint32 now);
+bool takeTokens(TokenBucket* bucket, float amount, Uint32 now);
+
+#endif
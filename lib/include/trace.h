@@ -0,0 +1,43 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+// Byggs med -DTRACE_ENABLED (make TRACE=1). Annars försvinner makrona helt.
+#ifdef TRACE_ENABLED
+
+// TRACE_SCOPE bygger på __attribute__((cleanup)), som bara GCC och Clang har
+#if !defined(__GNUC__)
+#error "TRACE_ENABLED kräver GCC eller Clang"
+#endif
+
+typedef struct {
+    const char* name;
+    Uint64 start;
+} TraceScope;
+
+void traceEndScope(TraceScope* scope);
+void traceSetThreadName(const char* name);
+bool traceWriteJson(const char* path);
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) \
+    TraceScope TRACE_CONCAT(traceScope, __LINE__) __attribute__((cleanup(traceEndScope))) = { name, SDL_GetPerformanceCounter() }
+#define TRACE_BEGIN(scope, name) TraceScope scope = { name, SDL_GetPerformanceCounter() }
+#define TRACE_END(scope) traceEndScope(&scope)
+#define TRACE_THREAD_NAME(name) traceSetThreadName(name)
+#define TRACE_WRITE(path) traceWriteJson(path)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_BEGIN(scope, name) ((void)0)
+#define TRACE_END(scope) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#define TRACE_WRITE(path) ((void)0)
+
+#endif
+
+#endif
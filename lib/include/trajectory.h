@@ -0,0 +1,43 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "wall.h"
+
+#define TRAJECTORY_MAX_BOUNCES 6
+#define TRAJECTORY_MAX_SEGMENTS (TRAJECTORY_MAX_BOUNCES + 1)
+#define TRAJECTORY_MAX_WALLS 32
+#define TRAJECTORY_CELL_SIZE 4
+#define TRAJECTORY_ANGLE_BUCKETS 720
+#define TRAJECTORY_CACHE_SIZE 4096
+
+// Koordinaterna är kulans övre vänstra hörn, samma som ServerBullet.x/y
+typedef struct {
+    SDL_FPoint start;
+    SDL_FPoint end;
+} TrajectorySegment;
+
+typedef struct {
+    TrajectorySegment segments[TRAJECTORY_MAX_SEGMENTS];
+    int numSegments;
+    float length;
+    bool leftArena;
+} Trajectory;
+
+typedef struct TrajectorySolver TrajectorySolver;
+
+TrajectorySolver* createTrajectorySolver(int arenaWidth, int arenaHeight, float bulletSize);
+void destroyTrajectorySolver(TrajectorySolver* solver);
+// Väggarna är statiska; att lägga till en vägg tömmer cachen
+bool addTrajectoryWall(TrajectorySolver* solver, const Wall* wall);
+
+// angle i grader med 0 = uppåt, samma konvention som tankarna
+void traceTrajectory(const TrajectorySolver* solver, float x, float y, float angle, Trajectory* out);
+// Memoiserad per (TRAJECTORY_CELL_SIZE-cell, vinkelhink); banan räknas från cellens och hinkens mitt
+const Trajectory* predictTrajectory(TrajectorySolver* solver, float x, float y, float angle);
+
+// Första målet som banan träffar, eller -1; hit får kulans position vid träffen
+int findTrajectoryHit(const TrajectorySolver* solver, const Trajectory* trajectory, const SDL_Rect* targets, int numTargets, SDL_FPoint* hit);
+
+#endif
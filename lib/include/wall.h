@@ -4,6 +4,9 @@
 #include <SDL.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include "arena.h"
+
+#define MAP_WALL_COUNT 4
 
 typedef enum {
     WALL_TOP_LEFT,
@@ -15,8 +18,14 @@ typedef enum {
 typedef struct Wall Wall;
 
 Wall* createWall(int x, int y, int thickness, int length, WallDirection dir);
+Wall* createWallInArena(Arena* arena, int x, int y, int thickness, int length, WallDirection dir);
+// Ordning: övre vänster, övre höger, nedre vänster, nedre höger
+bool createMapWalls(Arena* arena, int width, int height, Wall* walls[MAP_WALL_COUNT]);
+// Fyller points med tankpositioner (övre vänstra hörnet) som inte krockar med väggar eller varandra; returnerar antalet
+int createSpawnPoints(Wall* walls[MAP_WALL_COUNT], int width, int height, int tankSize, SDL_Point* points, int maxPoints);
 
-void renderWall(SDL_Renderer* renderer, Wall* wall);
+// offsetX/offsetY är kamerans position; väggen ritas på världspositionen minus den
+void renderWall(SDL_Renderer* renderer, Wall* wall, int offsetX, int offsetY);
 
 int wallCheckCollision(Wall* wall, SDL_Rect* player);
 
@@ -24,6 +33,8 @@ bool wallHitsVertical(Wall* topLeft, Wall* topRight, Wall* bottomLeft, Wall* bot
 
 bool wallHitsHorizontal(Wall* topLeft, Wall* topRight, Wall* bottomLeft, Wall* bottomRight, SDL_Rect* bullet);
 
+void getWallRects(const Wall* wall, SDL_Rect* vertical, SDL_Rect* horizontal);
+
 void destroyWall(Wall* wall);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "arena.h"
+#include <SDL.h>
+#include <stdlib.h>
+
+#define ARENA_ALIGNMENT 16
+
+struct Arena {
+    unsigned char* base;
+    size_t capacity;
+    size_t used;
+};
+
+Arena* createArena(size_t capacity) {
+    Arena* arena = malloc(sizeof(Arena));
+    if (!arena) return NULL;
+    arena->base = malloc(capacity);
+    if (!arena->base) {
+        free(arena);
+        return NULL;
+    }
+    arena->capacity = capacity;
+    arena->used = 0;
+    return arena;
+}
+
+void destroyArena(Arena* arena) {
+    if (!arena) return;
+    free(arena->base);
+    free(arena);
+}
+
+void* arenaAlloc(Arena* arena, size_t size) {
+    if (!arena) return NULL;
+    size_t offset = (arena->used + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (offset > arena->capacity || size > arena->capacity - offset) {
+        SDL_Log("arenaAlloc: arenan är full (%zu av %zu bytes)", arena->used, arena->capacity);
+        return NULL;
+    }
+    arena->used = offset + size;
+    return arena->base + offset;
+}
+
+void resetArena(Arena* arena) {
+    if (arena) arena->used = 0;
+}
+
+size_t getArenaUsed(const Arena* arena) {
+    return arena ? arena->used : 0;
+}
@@ -0,0 +1,162 @@
+#include "asset_loader.h"
+#include <stdlib.h>
+
+#define MAX_ASSET_WORKERS 8
+
+typedef enum {
+    ASSET_IMAGE,
+    ASSET_FILE
+} AssetKind;
+
+typedef struct {
+    AssetKind kind;
+    const char* path;
+    bool done;
+    SDL_Surface* surface;
+    void* data;
+    size_t size;
+} AssetJob;
+
+struct AssetLoader {
+    SDL_Thread* workers[MAX_ASSET_WORKERS];
+    int numWorkers;
+    SDL_mutex* lock;
+    SDL_cond* jobQueued;
+    SDL_cond* jobDone;
+    AssetJob jobs[MAX_ASSET_JOBS];
+    int numJobs;
+    int nextJob;
+    bool quit;
+};
+
+static int assetWorker(void* data) {
+    AssetLoader* loader = data;
+    SDL_LockMutex(loader->lock);
+    while (true) {
+        while (!loader->quit && loader->nextJob == loader->numJobs) {
+            SDL_CondWait(loader->jobQueued, loader->lock);
+        }
+        if (loader->nextJob == loader->numJobs) break;
+        AssetJob* job = &loader->jobs[loader->nextJob++];
+        SDL_UnlockMutex(loader->lock);
+
+        SDL_Surface* surface = NULL;
+        void* fileData = NULL;
+        size_t size = 0;
+        if (job->kind == ASSET_IMAGE) {
+            surface = IMG_Load(job->path);
+            if (!surface) SDL_Log("Kunde inte ladda %s: %s", job->path, IMG_GetError());
+        } else {
+            fileData = SDL_LoadFile(job->path, &size);
+            if (!fileData) SDL_Log("Kunde inte läsa %s: %s", job->path, SDL_GetError());
+        }
+
+        SDL_LockMutex(loader->lock);
+        job->surface = surface;
+        job->data = fileData;
+        job->size = size;
+        job->done = true;
+        SDL_CondBroadcast(loader->jobDone);
+    }
+    SDL_UnlockMutex(loader->lock);
+    return 0;
+}
+
+AssetLoader* createAssetLoader(int numWorkers) {
+    AssetLoader* loader = calloc(1, sizeof(AssetLoader));
+    if (!loader) return NULL;
+    loader->lock = SDL_CreateMutex();
+    loader->jobQueued = SDL_CreateCond();
+    loader->jobDone = SDL_CreateCond();
+    if (!loader->lock || !loader->jobQueued || !loader->jobDone) {
+        SDL_Log("createAssetLoader: %s", SDL_GetError());
+        destroyAssetLoader(loader);
+        return NULL;
+    }
+    if (numWorkers < 1) numWorkers = 1;
+    if (numWorkers > MAX_ASSET_WORKERS) numWorkers = MAX_ASSET_WORKERS;
+    for (int i = 0; i < numWorkers; i++) {
+        loader->workers[i] = SDL_CreateThread(assetWorker, "assetWorker", loader);
+        if (!loader->workers[i]) {
+            SDL_Log("SDL_CreateThread: %s", SDL_GetError());
+            break;
+        }
+        loader->numWorkers++;
+    }
+    if (loader->numWorkers == 0) {
+        destroyAssetLoader(loader);
+        return NULL;
+    }
+    return loader;
+}
+
+void destroyAssetLoader(AssetLoader* loader) {
+    if (!loader) return;
+    if (loader->lock) {
+        SDL_LockMutex(loader->lock);
+        loader->quit = true;
+        SDL_CondBroadcast(loader->jobQueued);
+        SDL_UnlockMutex(loader->lock);
+    }
+    for (int i = 0; i < loader->numWorkers; i++) {
+        SDL_WaitThread(loader->workers[i], NULL);
+    }
+    for (int i = 0; i < loader->numJobs; i++) {
+        if (loader->jobs[i].surface) SDL_FreeSurface(loader->jobs[i].surface);
+        if (loader->jobs[i].data) SDL_free(loader->jobs[i].data);
+    }
+    if (loader->jobDone) SDL_DestroyCond(loader->jobDone);
+    if (loader->jobQueued) SDL_DestroyCond(loader->jobQueued);
+    if (loader->lock) SDL_DestroyMutex(loader->lock);
+    free(loader);
+}
+
+static int queueAsset(AssetLoader* loader, AssetKind kind, const char* path) {
+    if (!loader) return -1;
+    SDL_LockMutex(loader->lock);
+    if (loader->numJobs == MAX_ASSET_JOBS) {
+        SDL_UnlockMutex(loader->lock);
+        SDL_Log("Asset-kön är full, kan inte köa %s", path);
+        return -1;
+    }
+    int job = loader->numJobs++;
+    loader->jobs[job] = (AssetJob){ .kind = kind, .path = path };
+    SDL_CondSignal(loader->jobQueued);
+    SDL_UnlockMutex(loader->lock);
+    return job;
+}
+
+int queueImageAsset(AssetLoader* loader, const char* path) {
+    return queueAsset(loader, ASSET_IMAGE, path);
+}
+
+int queueFileAsset(AssetLoader* loader, const char* path) {
+    return queueAsset(loader, ASSET_FILE, path);
+}
+
+static AssetJob* waitForAsset(AssetLoader* loader, int job) {
+    if (!loader || job < 0 || job >= loader->numJobs) return NULL;
+    SDL_LockMutex(loader->lock);
+    while (!loader->jobs[job].done) {
+        SDL_CondWait(loader->jobDone, loader->lock);
+    }
+    SDL_UnlockMutex(loader->lock);
+    return &loader->jobs[job];
+}
+
+SDL_Surface* takeImageAsset(AssetLoader* loader, int job) {
+    AssetJob* done = waitForAsset(loader, job);
+    if (!done) return NULL;
+    SDL_Surface* surface = done->surface;
+    done->surface = NULL;
+    return surface;
+}
+
+void* takeFileAsset(AssetLoader* loader, int job, size_t* size) {
+    AssetJob* done = waitForAsset(loader, job);
+    if (!done) return NULL;
+    void* data = done->data;
+    if (size) *size = done->size;
+    done->data = NULL;
+    return data;
+}
@@ -0,0 +1,231 @@
+#include "async_log.h"
+#include "spsc_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_RING_SIZE 1024
+#define LOG_STRING_SIZE 48
+#define LOG_LINE_SIZE 512
+#define LOG_FLUSH_MS 20
+
+#if defined(_MSC_VER)
+#define LOG_THREAD_LOCAL __declspec(thread)
+#else
+#define LOG_THREAD_LOCAL _Thread_local
+#endif
+
+// Strängargument kopieras till strings och pekas ut med en offset i value.u
+typedef struct {
+    const char* format;
+    int numArgs;
+    int suppressed;
+    LogArg args[LOG_MAX_ARGS];
+    char strings[LOG_STRING_SIZE];
+} LogEntry;
+
+typedef struct LogRing {
+    SpscQueue* queue;
+    SDL_atomic_t dropped;
+    struct LogRing* next;
+} LogRing;
+
+// Ringarna lever resten av programmet, eftersom trådarna behåller sina pekare
+static LOG_THREAD_LOCAL LogRing* localRing = NULL;
+static LogRing* rings = NULL;
+static SDL_SpinLock ringsLock = 0;
+static SDL_atomic_t logRunning;
+// Antal trådar som är mitt i logWrite; stopAsyncLog väntar in dem innan sista genomgången
+static SDL_atomic_t activeWriters;
+static SDL_Thread* flushThreadHandle = NULL;
+
+// Bara första meddelandet på en tråd tar låset, sedan skriver varje tråd i sin egen ring
+static LogRing* getLocalRing(void) {
+    if (localRing) return localRing;
+    LogRing* ring = calloc(1, sizeof(LogRing));
+    if (!ring) return NULL;
+    ring->queue = createSpscQueue(LOG_RING_SIZE, sizeof(LogEntry));
+    if (!ring->queue) {
+        free(ring);
+        return NULL;
+    }
+    SDL_AtomicLock(&ringsLock);
+    ring->next = rings;
+    rings = ring;
+    SDL_AtomicUnlock(&ringsLock);
+    localRing = ring;
+    return ring;
+}
+
+// -1 när anropet ska tystas, annars hur många som tystats sedan förra utskriften
+static int checkLimit(LogLimit* limit, int perSecond) {
+    int window = (int)(SDL_GetTicks() / 1000);
+    int current = SDL_AtomicGet(&limit->window);
+    if (current != window && SDL_AtomicCAS(&limit->window, current, window)) {
+        SDL_AtomicSet(&limit->count, 0);
+    }
+    if (SDL_AtomicAdd(&limit->count, 1) >= perSecond) {
+        SDL_AtomicIncRef(&limit->suppressed);
+        return -1;
+    }
+    return SDL_AtomicSet(&limit->suppressed, 0);
+}
+
+static void fillEntry(LogEntry* entry, const char* format, int numArgs, const LogArg* args, int suppressed) {
+    entry->format = format;
+    entry->numArgs = numArgs < LOG_MAX_ARGS ? numArgs : LOG_MAX_ARGS;
+    entry->suppressed = suppressed;
+    int used = 0;
+    for (int i = 0; i < entry->numArgs; i++) {
+        entry->args[i] = args[i];
+        if (args[i].type != LOG_ARG_STRING) continue;
+        const char* text = args[i].value.s ? args[i].value.s : "(null)";
+        int room = LOG_STRING_SIZE - used;
+        int len = (int)strlen(text);
+        if (len >= room) len = room > 0 ? room - 1 : 0;
+        entry->args[i].value.u = used;
+        if (room > 0) {
+            memcpy(entry->strings + used, text, len);
+            entry->strings[used + len] = '\0';
+            used += len + 1;
+        } else {
+            entry->args[i].value.u = LOG_STRING_SIZE - 1;
+        }
+    }
+    if (used == 0) entry->strings[LOG_STRING_SIZE - 1] = '\0';
+}
+
+// Varje konvertering formateras för sig med argumentets lagrade typ; längdmodifierare i
+// formatsträngen ersätts, så %d och %ld fungerar lika för alla heltal
+static void formatEntry(const LogEntry* entry, char* line, int size) {
+    int len = 0;
+    int arg = 0;
+    const char* f = entry->format;
+    while (*f && len < size - 1) {
+        if (*f != '%') {
+            line[len++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            line[len++] = '%';
+            f += 2;
+            continue;
+        }
+        char spec[24];
+        int n = 0;
+        spec[n++] = *f++;
+        while (*f && strchr("-+ #0123456789.", *f) && n < 16) spec[n++] = *f++;
+        while (*f && strchr("hlLqjzt", *f)) f++;
+        char conversion = *f;
+        if (!conversion) break;
+        f++;
+        if (arg >= entry->numArgs) {
+            line[len++] = '?';
+            continue;
+        }
+        const LogArg* a = &entry->args[arg++];
+        double d = a->type == LOG_ARG_DOUBLE ? a->value.d :
+                   a->type == LOG_ARG_UINT ? (double)a->value.u : (double)a->value.i;
+        long long i = a->type == LOG_ARG_DOUBLE ? (long long)a->value.d : (long long)a->value.i;
+        int written = 0;
+        switch (conversion) {
+            case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+                spec[n++] = 'l';
+                spec[n++] = 'l';
+                spec[n++] = conversion;
+                spec[n] = '\0';
+                written = snprintf(line + len, size - len, spec, i);
+                break;
+            case 'c':
+                spec[n++] = 'c';
+                spec[n] = '\0';
+                written = snprintf(line + len, size - len, spec, (int)i);
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                spec[n++] = conversion;
+                spec[n] = '\0';
+                written = snprintf(line + len, size - len, spec, d);
+                break;
+            case 's':
+                spec[n++] = 's';
+                spec[n] = '\0';
+                written = snprintf(line + len, size - len, spec,
+                                   a->type == LOG_ARG_STRING ? entry->strings + a->value.u : "?");
+                break;
+            case 'p':
+                written = snprintf(line + len, size - len, "%p", a->value.p);
+                break;
+            default:
+                written = snprintf(line + len, size - len, "%s%c", spec, conversion);
+                break;
+        }
+        if (written > 0) len += written < size - len ? written : size - len - 1;
+    }
+    line[len] = '\0';
+    if (entry->suppressed > 0 && len < size - 1) {
+        snprintf(line + len, size - len, " (+%d suppressed)", entry->suppressed);
+    }
+}
+
+static void printEntry(const LogEntry* entry) {
+    char line[LOG_LINE_SIZE];
+    formatEntry(entry, line, sizeof(line));
+    SDL_Log("%s", line);
+}
+
+static void flushRings(void) {
+    static LogEntry entry;
+    SDL_AtomicLock(&ringsLock);
+    LogRing* allRings = rings;
+    SDL_AtomicUnlock(&ringsLock);
+    for (LogRing* ring = allRings; ring; ring = ring->next) {
+        while (popSpscQueue(ring->queue, &entry)) printEntry(&entry);
+        int dropped = SDL_AtomicSet(&ring->dropped, 0);
+        if (dropped > 0) SDL_Log("Loggkön full, %d meddelanden tappade", dropped);
+    }
+}
+
+static int flushThread(void* data) {
+    while (true) {
+        bool stopping = !SDL_AtomicGet(&logRunning);
+        flushRings();
+        if (stopping) break;
+        SDL_Delay(LOG_FLUSH_MS);
+    }
+    return 0;
+}
+
+bool startAsyncLog(void) {
+    if (flushThreadHandle) return true;
+    SDL_AtomicSet(&logRunning, 1);
+    flushThreadHandle = SDL_CreateThread(flushThread, "logFlush", NULL);
+    if (!flushThreadHandle) {
+        SDL_AtomicSet(&logRunning, 0);
+        SDL_Log("SDL_CreateThread: %s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+// En producent som redan sett logRunning satt hinner köa klart innan sista genomgången;
+// alla senare anrop ser den nollställd och skriver direkt
+void stopAsyncLog(void) {
+    if (!flushThreadHandle) return;
+    SDL_AtomicSet(&logRunning, 0);
+    SDL_WaitThread(flushThreadHandle, NULL);
+    flushThreadHandle = NULL;
+    while (SDL_AtomicGet(&activeWriters) > 0) SDL_Delay(1);
+    flushRings();
+}
+
+void logWrite(LogLimit* limit, int perSecond, const char* format, int numArgs, const LogArg* args) {
+    int suppressed = checkLimit(limit, perSecond);
+    if (suppressed < 0) return;
+    LogEntry entry;
+    fillEntry(&entry, format, numArgs, args, suppressed);
+    SDL_AtomicIncRef(&activeWriters);
+    LogRing* ring = SDL_AtomicGet(&logRunning) ? getLocalRing() : NULL;
+    if (ring && !pushSpscQueue(ring->queue, &entry)) SDL_AtomicIncRef(&ring->dropped);
+    SDL_AtomicAdd(&activeWriters, -1);
+    if (!ring) printEntry(&entry);
+}
@@ -5,26 +5,6 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-static SDL_Texture* bulletTexture = NULL;
-
-void loadBulletTexture(SDL_Renderer* renderer) 
-{
-    bulletTexture = IMG_LoadTexture(renderer, "../lib/resources/bullet.png");
-    if (!bulletTexture) 
-    {
-        SDL_Log("Kunde inte ladda bullet.png: %s", IMG_GetError());
-    }
-}
-
-void destroyBulletTexture() 
-{
-    if (bulletTexture) 
-    {
-        SDL_DestroyTexture(bulletTexture);
-        bulletTexture = NULL;
-    }
-}
-
 void initBullet(Bullet* bullet) 
 {
     bullet->rect.x = 0;
@@ -63,11 +43,11 @@ void updateBullet(Bullet* bullet, float delta_time)
     }
 }
 
-void renderBullet(SDL_Renderer* renderer, Bullet* bullet) 
+void renderBullet(SpriteBatch* batch, Bullet* bullet) 
 {
-    if (!bullet->active || !bulletTexture) return;
+    if (!bullet->active) return;
 
-    SDL_RenderCopyF(renderer, bulletTexture, NULL, &bullet->rect);
+    addSprite(batch, SPRITE_BULLET, &bullet->rect, 0.0f);
 }
 
 bool bulletOutOfBounds(Bullet* bullet) 
@@ -29,17 +29,17 @@ void fireServerBullet(ServerBullet* bullet, float startX, float startY, float an
 }
 
 
-void updateServerBullet(ServerBullet* bullet, float delta_time) {
+void updateServerBullet(ServerBullet* bullet, float delta_time, int worldWidth, int worldHeight) {
     if (!bullet->active) return;
 
     bullet->x += bullet->velocityX * delta_time;
     bullet->y += bullet->velocityY * delta_time;
 
-    if (serverBulletOutOfBounds(bullet)) {
+    if (serverBulletOutOfBounds(bullet, worldWidth, worldHeight)) {
         bullet->active = false;
     }
 }
 
-bool serverBulletOutOfBounds(ServerBullet* bullet) {
-    return bullet->x < 0 || bullet->x > 800 || bullet->y < 0 || bullet->y > 600;
+bool serverBulletOutOfBounds(ServerBullet* bullet, int worldWidth, int worldHeight) {
+    return bullet->x < 0 || bullet->x > worldWidth || bullet->y < 0 || bullet->y > worldHeight;
 }
@@ -0,0 +1,31 @@
+#include "camera.h"
+#include <math.h>
+
+static float clampAxis(float center, int view, int world) {
+    if (world <= view) return (world - view) / 2.0f;
+    float origin = center - view / 2.0f;
+    if (origin < 0.0f) return 0.0f;
+    if (origin > world - view) return (float)(world - view);
+    return origin;
+}
+
+void initCamera(Camera* camera, int viewWidth, int viewHeight, int worldWidth, int worldHeight) {
+    camera->viewWidth = viewWidth;
+    camera->viewHeight = viewHeight;
+    camera->worldWidth = worldWidth;
+    camera->worldHeight = worldHeight;
+    followCamera(camera, worldWidth / 2.0f, worldHeight / 2.0f);
+}
+
+// Hela pixlar, så att väggar (heltal) och sprites (flyttal) inte glider isär när kameran rör sig
+void followCamera(Camera* camera, float x, float y) {
+    camera->x = floorf(clampAxis(x, camera->viewWidth, camera->worldWidth));
+    camera->y = floorf(clampAxis(y, camera->viewHeight, camera->worldHeight));
+}
+
+bool isOnCamera(const Camera* camera, const SDL_FRect* rect, float margin) {
+    return rect->x + rect->w > camera->x - margin &&
+           rect->y + rect->h > camera->y - margin &&
+           rect->x < camera->x + camera->viewWidth + margin &&
+           rect->y < camera->y + camera->viewHeight + margin;
+}
@@ -0,0 +1,55 @@
+#include "clock_sync.h"
+#include <string.h>
+
+void initClockSync(ClockSync* clock) {
+    memset(clock, 0, sizeof(ClockSync));
+}
+
+// Täta pingar tills fönstret är fullt, sedan bara så ofta att drift hinner följas
+bool isClockPingDue(const ClockSync* clock, Uint32 now) {
+    Uint32 interval = clock->numSamples < CLOCK_SYNC_SAMPLES ? CLOCK_SYNC_FAST_INTERVAL_MS : CLOCK_SYNC_INTERVAL_MS;
+    return now - clock->lastPingSent >= interval;
+}
+
+void markClockPingSent(ClockSync* clock, Uint32 now) {
+    clock->lastPingSent = now;
+}
+
+void addClockSample(ClockSync* clock, Uint32 clientSent, Uint32 serverTime, Uint32 now) {
+    Uint32 rtt = now - clientSent;
+    if (rtt > 10000) return;
+    // Servern antas ha svarat mitt i rundturen
+    double offset = (double)(Sint32)(serverTime - now) + rtt / 2.0;
+    clock->offset[clock->nextSample] = offset;
+    clock->rtt[clock->nextSample] = rtt;
+    clock->nextSample = (clock->nextSample + 1) % CLOCK_SYNC_SAMPLES;
+    if (clock->numSamples < CLOCK_SYNC_SAMPLES) clock->numSamples++;
+    clock->smoothedRtt = clock->numSamples == 1 ? (float)rtt : 0.875f * clock->smoothedRtt + 0.125f * rtt;
+
+    int best = 0;
+    for (int i = 1; i < clock->numSamples; i++) {
+        if (clock->rtt[i] < clock->rtt[best]) best = i;
+    }
+    clock->targetOffset = clock->offset[best];
+    double error = clock->targetOffset - clock->currentOffset;
+    if (!clock->synced || error > CLOCK_SYNC_SNAP_MS || error < -CLOCK_SYNC_SNAP_MS) {
+        clock->currentOffset = clock->targetOffset;
+        clock->synced = true;
+    }
+    clock->lastUpdate = now;
+}
+
+void updateClockSync(ClockSync* clock, Uint32 now) {
+    if (!clock->synced) return;
+    double maxStep = (now - clock->lastUpdate) * CLOCK_SYNC_SLEW_PER_SECOND / 1000.0;
+    clock->lastUpdate = now;
+    double error = clock->targetOffset - clock->currentOffset;
+    if (error > maxStep) error = maxStep;
+    if (error < -maxStep) error = -maxStep;
+    clock->currentOffset += error;
+}
+
+Uint32 getServerTime(const ClockSync* clock, Uint32 now) {
+    Sint64 offset = (Sint64)(clock->currentOffset < 0 ? clock->currentOffset - 0.5 : clock->currentOffset + 0.5);
+    return now + (Uint32)offset;
+}
@@ -0,0 +1,108 @@
+#include "frame_pacer.h"
+#include "text.h"
+#include <stdio.h>
+#include <string.h>
+
+#define OVERLAY_X 8
+#define OVERLAY_Y 8
+#define OVERLAY_W (FRAME_HISTORY * 2 + 16)
+#define OVERLAY_H 120
+#define HISTOGRAM_H 60
+#define HISTOGRAM_MAX_MS 50.0f
+
+static float ticksToMs(const FramePacer* pacer, Uint64 ticks) {
+    return (float)((double)ticks * 1000.0 / pacer->frequency);
+}
+
+void initFramePacer(FramePacer* pacer, int targetFps, bool vsync) {
+    memset(pacer, 0, sizeof(FramePacer));
+    pacer->frequency = SDL_GetPerformanceFrequency();
+    pacer->frameBudget = pacer->frequency / (targetFps > 0 ? targetFps : 60);
+    pacer->vsync = vsync;
+    pacer->frameStart = SDL_GetPerformanceCounter();
+    pacer->phaseStart = pacer->frameStart;
+    pacer->nextDeadline = pacer->frameStart + pacer->frameBudget;
+}
+
+void beginFrame(FramePacer* pacer) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    pacer->frameMs[pacer->historyIndex] = ticksToMs(pacer, now - pacer->frameStart);
+    pacer->historyIndex = (pacer->historyIndex + 1) % FRAME_HISTORY;
+    pacer->frameStart = now;
+    pacer->phaseStart = now;
+}
+
+void endFramePhase(FramePacer* pacer, FramePhase phase) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    pacer->phaseMs[phase] = ticksToMs(pacer, now - pacer->phaseStart);
+    pacer->phaseStart = now;
+}
+
+void endFrame(FramePacer* pacer) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (pacer->vsync) {
+        pacer->nextDeadline = now + pacer->frameBudget;
+        return;
+    }
+    // Ligger vi mer än en hel frame efter börjar vi om i stället för att försöka komma ikapp
+    if (now > pacer->nextDeadline + pacer->frameBudget) {
+        pacer->nextDeadline = now;
+    }
+    Uint64 oneMs = pacer->frequency / 1000;
+    while (now < pacer->nextDeadline) {
+        Uint64 remaining = pacer->nextDeadline - now;
+        if (remaining > 2 * oneMs) {
+            SDL_Delay((Uint32)(remaining / oneMs) - 1);
+        }
+        now = SDL_GetPerformanceCounter();
+    }
+    pacer->nextDeadline += pacer->frameBudget;
+}
+
+void toggleFrameOverlay(FramePacer* pacer) {
+    pacer->showOverlay = !pacer->showOverlay;
+}
+
+void renderFrameOverlay(SDL_Renderer* renderer, const FramePacer* pacer) {
+    if (!pacer->showOverlay) return;
+
+    int last = (pacer->historyIndex + FRAME_HISTORY - 1) % FRAME_HISTORY;
+    float frameMs = pacer->frameMs[last];
+    float worstMs = 0.0f;
+    for (int i = 0; i < FRAME_HISTORY; i++) {
+        if (pacer->frameMs[i] > worstMs) worstMs = pacer->frameMs[i];
+    }
+
+    SDL_Rect panel = {OVERLAY_X, OVERLAY_Y, OVERLAY_W, OVERLAY_H};
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+    SDL_RenderFillRect(renderer, &panel);
+
+    char line[96];
+    SDL_Color white = {255, 255, 255, 255};
+    snprintf(line, sizeof(line), "frame %.2f ms (%.0f fps)  worst %.1f ms", frameMs, frameMs > 0.0f ? 1000.0f / frameMs : 0.0f, worstMs);
+    renderSmallText(renderer, line, OVERLAY_X + 6, OVERLAY_Y + 4, white);
+    snprintf(line, sizeof(line), "update %.2f  render %.2f  present %.2f ms%s",
+             pacer->phaseMs[FRAME_PHASE_UPDATE], pacer->phaseMs[FRAME_PHASE_RENDER],
+             pacer->phaseMs[FRAME_PHASE_PRESENT], pacer->vsync ? "  vsync" : "");
+    renderSmallText(renderer, line, OVERLAY_X + 6, OVERLAY_Y + 22, white);
+
+    int baseY = OVERLAY_Y + OVERLAY_H - 8;
+    float budgetMs = ticksToMs(pacer, pacer->frameBudget);
+    for (int i = 0; i < FRAME_HISTORY; i++) {
+        float ms = pacer->frameMs[(pacer->historyIndex + i) % FRAME_HISTORY];
+        if (ms > HISTOGRAM_MAX_MS) ms = HISTOGRAM_MAX_MS;
+        int h = (int)(ms / HISTOGRAM_MAX_MS * HISTOGRAM_H);
+        SDL_Rect bar = {OVERLAY_X + 8 + i * 2, baseY - h, 2, h};
+        if (ms > budgetMs * 1.5f) {
+            SDL_SetRenderDrawColor(renderer, 230, 60, 60, 255);
+        } else {
+            SDL_SetRenderDrawColor(renderer, 80, 220, 120, 255);
+        }
+        SDL_RenderFillRect(renderer, &bar);
+    }
+    int budgetY = baseY - (int)(budgetMs / HISTOGRAM_MAX_MS * HISTOGRAM_H);
+    SDL_SetRenderDrawColor(renderer, 255, 220, 0, 255);
+    SDL_RenderDrawLine(renderer, OVERLAY_X + 8, budgetY, OVERLAY_X + 8 + FRAME_HISTORY * 2, budgetY);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+}
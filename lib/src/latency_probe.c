@@ -0,0 +1,108 @@
+#include "latency_probe.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* segmentNames[PROBE_SEGMENT_COUNT] = {
+    "input->send",
+    "network+tick",
+    "receive->present",
+    "total"
+};
+
+static float elapsedMs(const LatencyProbe* probe, Uint64 from, Uint64 to) {
+    return (to - from) * 1000.0f / probe->frequency;
+}
+
+// Slumpad paus mellan proven så att de inte alltid hamnar i samma fas av serverns tick
+static void scheduleNext(LatencyProbe* probe, Uint64 now) {
+    Uint64 settle = LATENCY_PROBE_SETTLE_MS + rand() % 100;
+    probe->nextInjectAt = now + settle * probe->frequency / 1000;
+    probe->phase = probe->numSamples >= probe->targetSamples ? PROBE_DONE : PROBE_WAITING;
+}
+
+static int compareFloats(const void* a, const void* b) {
+    float x = *(const float*)a;
+    float y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static float percentile(const float* sorted, int count, float p) {
+    int index = (int)(p * (count - 1) + 0.5f);
+    return sorted[index];
+}
+
+void initLatencyProbe(LatencyProbe* probe, int targetSamples) {
+    memset(probe, 0, sizeof(LatencyProbe));
+    probe->frequency = SDL_GetPerformanceFrequency();
+    if (targetSamples < 1) targetSamples = 1;
+    if (targetSamples > LATENCY_PROBE_MAX_SAMPLES) targetSamples = LATENCY_PROBE_MAX_SAMPLES;
+    probe->targetSamples = targetSamples;
+    probe->phase = PROBE_WAITING;
+    probe->nextInjectAt = SDL_GetPerformanceCounter() + probe->frequency;
+}
+
+bool shouldInjectProbe(LatencyProbe* probe, Uint64 now) {
+    if (probe->phase == PROBE_WAITING) return !probe->keyHeld && now >= probe->nextInjectAt;
+    if ((probe->phase == PROBE_INJECTED || probe->phase == PROBE_SENT) &&
+        elapsedMs(probe, probe->injectedAt, now) > LATENCY_PROBE_TIMEOUT_MS) {
+        SDL_Log("Latency probe: ingen ändring inom %d ms, försöker igen", LATENCY_PROBE_TIMEOUT_MS);
+        probe->timeouts++;
+        scheduleNext(probe, now);
+    }
+    return false;
+}
+
+void markProbeInjected(LatencyProbe* probe, Uint64 now, float baselineAngle) {
+    probe->phase = PROBE_INJECTED;
+    probe->keyHeld = true;
+    probe->injectedAt = now;
+    probe->baselineAngle = baselineAngle;
+}
+
+void markProbeSent(LatencyProbe* probe, Uint64 now) {
+    if (probe->phase != PROBE_INJECTED) return;
+    probe->phase = PROBE_SENT;
+    probe->sentAt = now;
+}
+
+void markProbeReceived(LatencyProbe* probe, Uint64 now, float angle) {
+    if (probe->phase != PROBE_SENT || angle == probe->baselineAngle) return;
+    probe->phase = PROBE_RECEIVED;
+    probe->receivedAt = now;
+}
+
+void markProbePresented(LatencyProbe* probe, Uint64 now) {
+    if (probe->phase != PROBE_RECEIVED) return;
+    int i = probe->numSamples++;
+    probe->samples[PROBE_SEGMENT_INPUT_TO_SEND][i] = elapsedMs(probe, probe->injectedAt, probe->sentAt);
+    probe->samples[PROBE_SEGMENT_NETWORK][i] = elapsedMs(probe, probe->sentAt, probe->receivedAt);
+    probe->samples[PROBE_SEGMENT_RECEIVE_TO_PRESENT][i] = elapsedMs(probe, probe->receivedAt, now);
+    probe->samples[PROBE_SEGMENT_TOTAL][i] = elapsedMs(probe, probe->injectedAt, now);
+    scheduleNext(probe, now);
+}
+
+bool shouldReleaseProbe(LatencyProbe* probe) {
+    if (!probe->keyHeld || probe->phase == PROBE_INJECTED || probe->phase == PROBE_SENT || probe->phase == PROBE_RECEIVED) {
+        return false;
+    }
+    probe->keyHeld = false;
+    return true;
+}
+
+bool isLatencyProbeDone(const LatencyProbe* probe) {
+    return probe->phase == PROBE_DONE;
+}
+
+void reportLatencyProbe(LatencyProbe* probe) {
+    SDL_Log("Latency probe: %d prov, %d timeouts", probe->numSamples, probe->timeouts);
+    if (probe->numSamples == 0) return;
+    for (int s = 0; s < PROBE_SEGMENT_COUNT; s++) {
+        float* sorted = probe->samples[s];
+        qsort(sorted, probe->numSamples, sizeof(float), compareFloats);
+        SDL_Log("  %-17s p50 %6.1f ms  p90 %6.1f ms  p99 %6.1f ms  max %6.1f ms", segmentNames[s],
+                percentile(sorted, probe->numSamples, 0.50f),
+                percentile(sorted, probe->numSamples, 0.90f),
+                percentile(sorted, probe->numSamples, 0.99f),
+                sorted[probe->numSamples - 1]);
+    }
+}
@@ -0,0 +1,80 @@
+#include "packet_capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CAPTURE_MAGIC "RTCAP\x01\0\0"
+#define CAPTURE_MAGIC_SIZE 8
+#define CAPTURE_RECORD_HEADER 12
+
+struct PacketCapture {
+    FILE* file;
+    Uint32 startTime;
+};
+
+static PacketCapture* openCapture(const char* path, const char* mode) {
+    PacketCapture* capture = calloc(1, sizeof(PacketCapture));
+    if (!capture) return NULL;
+    capture->file = fopen(path, mode);
+    if (!capture->file) {
+        SDL_Log("Kunde inte öppna capture-filen %s", path);
+        free(capture);
+        return NULL;
+    }
+    return capture;
+}
+
+PacketCapture* openCaptureWriter(const char* path, Uint32 now) {
+    PacketCapture* capture = openCapture(path, "wb");
+    if (!capture) return NULL;
+    capture->startTime = now;
+    // Stor buffert: posterna skrivs från mottagningsloopen och ska inte ge ett systemanrop per paket
+    setvbuf(capture->file, NULL, _IOFBF, 1 << 16);
+    fwrite(CAPTURE_MAGIC, 1, CAPTURE_MAGIC_SIZE, capture->file);
+    return capture;
+}
+
+void writeCapturedPacket(PacketCapture* capture, const UDPpacket* packet, Uint32 now) {
+    if (!capture || packet->len <= 0 || packet->len > CAPTURE_MAX_PACKET) return;
+    Uint8 header[CAPTURE_RECORD_HEADER];
+    SDLNet_Write32(now - capture->startTime, header);
+    // host och port ligger redan i nätverksordning i IPaddress
+    memcpy(header + 4, &packet->address.host, 4);
+    memcpy(header + 8, &packet->address.port, 2);
+    SDLNet_Write16((Uint16)packet->len, header + 10);
+    fwrite(header, 1, CAPTURE_RECORD_HEADER, capture->file);
+    fwrite(packet->data, 1, packet->len, capture->file);
+}
+
+PacketCapture* openCaptureReader(const char* path) {
+    PacketCapture* capture = openCapture(path, "rb");
+    if (!capture) return NULL;
+    char magic[CAPTURE_MAGIC_SIZE];
+    if (fread(magic, 1, CAPTURE_MAGIC_SIZE, capture->file) != CAPTURE_MAGIC_SIZE ||
+        memcmp(magic, CAPTURE_MAGIC, CAPTURE_MAGIC_SIZE) != 0) {
+        SDL_Log("%s är ingen capture-fil", path);
+        closeCapture(capture);
+        return NULL;
+    }
+    return capture;
+}
+
+bool readCapturedPacket(PacketCapture* capture, CapturedPacket* out) {
+    Uint8 header[CAPTURE_RECORD_HEADER];
+    if (fread(header, 1, CAPTURE_RECORD_HEADER, capture->file) != CAPTURE_RECORD_HEADER) return false;
+    out->time = SDLNet_Read32(header);
+    memcpy(&out->address.host, header + 4, 4);
+    memcpy(&out->address.port, header + 8, 2);
+    out->len = SDLNet_Read16(header + 10);
+    if (out->len > CAPTURE_MAX_PACKET) {
+        SDL_Log("Trasig capture-post (%d bytes)", out->len);
+        return false;
+    }
+    return fread(out->data, 1, out->len, capture->file) == (size_t)out->len;
+}
+
+void closeCapture(PacketCapture* capture) {
+    if (!capture) return;
+    if (capture->file) fclose(capture->file);
+    free(capture);
+}
@@ -0,0 +1,166 @@
+#include "reliable_channel.h"
+#include <string.h>
+
+static bool sequenceBefore(Uint16 a, Uint16 b) {
+    return (Sint16)(a - b) < 0;
+}
+
+static void sendPacket(ReliableChannel* channel, UDPsocket socket, UDPpacket* packet) {
+    if (channel->send) {
+        channel->send(packet);
+    } else {
+        SDLNet_UDP_Send(socket, -1, packet);
+    }
+}
+
+static void transmit(ReliableChannel* channel, UDPsocket socket, UDPpacket* packet, const ReliableMessage* message) {
+    ControlHeader header = { CONTROL_DATA, message->sequence, channel->nextExpectedSequence };
+    memcpy(packet->data, &header, sizeof(ControlHeader));
+    memcpy(packet->data + sizeof(ControlHeader), message->data, message->len);
+    packet->len = sizeof(ControlHeader) + message->len;
+    packet->address = channel->address;
+    sendPacket(channel, socket, packet);
+}
+
+static void sendAck(ReliableChannel* channel, UDPsocket socket, UDPpacket* packet) {
+    ControlHeader header = { CONTROL_ACK, 0, channel->nextExpectedSequence };
+    memcpy(packet->data, &header, sizeof(ControlHeader));
+    packet->len = sizeof(ControlHeader);
+    packet->address = channel->address;
+    sendPacket(channel, socket, packet);
+}
+
+// RFC 6298-utjämning, men med spelvänliga gränser i stället för 1 s minimum
+static void addRttSample(ReliableChannel* channel, Uint32 sample) {
+    if (!channel->hasRttSample) {
+        channel->smoothedRtt = sample;
+        channel->rttVariance = sample / 2.0f;
+        channel->hasRttSample = true;
+    } else {
+        float error = sample - channel->smoothedRtt;
+        if (error < 0) error = -error;
+        channel->rttVariance = 0.75f * channel->rttVariance + 0.25f * error;
+        channel->smoothedRtt = 0.875f * channel->smoothedRtt + 0.125f * sample;
+    }
+    Uint32 rto = (Uint32)(channel->smoothedRtt + 4.0f * channel->rttVariance);
+    if (rto < RELIABLE_MIN_RTO) rto = RELIABLE_MIN_RTO;
+    if (rto > RELIABLE_MAX_RTO) rto = RELIABLE_MAX_RTO;
+    channel->rto = rto;
+}
+
+static void handleAck(ReliableChannel* channel, Uint16 ack, Uint32 now) {
+    for (int i = 0; i < RELIABLE_WINDOW; i++) {
+        ReliableMessage* message = &channel->pending[i];
+        if (!message->inUse || !sequenceBefore(message->sequence, ack)) continue;
+        if (message->retries == 0) {
+            addRttSample(channel, now - message->sentAt);
+        }
+        message->inUse = false;
+    }
+}
+
+void initReliableChannel(ReliableChannel* channel, IPaddress address) {
+    memset(channel, 0, sizeof(ReliableChannel));
+    channel->address = address;
+    channel->rto = RELIABLE_INITIAL_RTO;
+}
+
+bool isControlPacket(const UDPpacket* packet) {
+    if (packet->len < (int)sizeof(ControlHeader)) return false;
+    int command;
+    memcpy(&command, packet->data, sizeof(int));
+    return command == CONTROL_DATA || command == CONTROL_ACK;
+}
+
+bool sendReliable(ReliableChannel* channel, UDPsocket socket, UDPpacket* packet, const void* data, int len, Uint32 now) {
+    if (len > MAX_CONTROL_PAYLOAD) {
+        SDL_Log("sendReliable: meddelandet är för stort (%d bytes)", len);
+        return false;
+    }
+    ReliableMessage* slot = NULL;
+    for (int i = 0; i < RELIABLE_WINDOW; i++) {
+        if (!channel->pending[i].inUse) {
+            slot = &channel->pending[i];
+            break;
+        }
+    }
+    if (!slot) {
+        SDL_Log("sendReliable: sändfönstret är fullt");
+        return false;
+    }
+    slot->inUse = true;
+    slot->sequence = channel->nextSendSequence++;
+    slot->sentAt = now;
+    slot->retries = 0;
+    slot->len = len;
+    memcpy(slot->data, data, len);
+    transmit(channel, socket, packet, slot);
+    return true;
+}
+
+void handleReliablePacket(ReliableChannel* channel, UDPsocket socket, UDPpacket* packet, Uint32 now) {
+    ControlHeader header;
+    memcpy(&header, packet->data, sizeof(ControlHeader));
+    handleAck(channel, header.ack, now);
+    if (header.command != CONTROL_DATA) return;
+
+    int len = packet->len - (int)sizeof(ControlHeader);
+    Uint16 offset = header.sequence - channel->nextDeliverSequence;
+    if (len > 0 && len <= MAX_CONTROL_PAYLOAD && offset < RELIABLE_WINDOW &&
+        !sequenceBefore(header.sequence, channel->nextExpectedSequence)) {
+        ReliableMessage* slot = &channel->received[header.sequence % RELIABLE_WINDOW];
+        if (!slot->inUse) {
+            slot->inUse = true;
+            slot->sequence = header.sequence;
+            slot->len = len;
+            memcpy(slot->data, packet->data + sizeof(ControlHeader), len);
+        }
+        while (true) {
+            ReliableMessage* next = &channel->received[channel->nextExpectedSequence % RELIABLE_WINDOW];
+            if (!next->inUse || next->sequence != channel->nextExpectedSequence) break;
+            channel->nextExpectedSequence++;
+        }
+    }
+    // Dubbletter kvitteras också, annars slutar aldrig avsändaren skicka om
+    sendAck(channel, socket, packet);
+}
+
+int receiveReliable(ReliableChannel* channel, void* out, int maxLen) {
+    if (channel->nextDeliverSequence == channel->nextExpectedSequence) return 0;
+    ReliableMessage* slot = &channel->received[channel->nextDeliverSequence % RELIABLE_WINDOW];
+    int len = slot->len < maxLen ? slot->len : maxLen;
+    memcpy(out, slot->data, len);
+    slot->inUse = false;
+    channel->nextDeliverSequence++;
+    return len;
+}
+
+void updateReliableChannel(ReliableChannel* channel, UDPsocket socket, UDPpacket* packet, Uint32 now) {
+    for (int i = 0; i < RELIABLE_WINDOW; i++) {
+        ReliableMessage* message = &channel->pending[i];
+        if (!message->inUse) continue;
+        int backoff = message->retries < 4 ? message->retries : 4;
+        if (now - message->sentAt < (channel->rto << backoff)) continue;
+        if (message->retries >= RELIABLE_MAX_RETRIES) {
+            channel->failed = true;
+            message->inUse = false;
+            continue;
+        }
+        message->retries++;
+        message->sentAt = now;
+        transmit(channel, socket, packet, message);
+    }
+}
+
+bool getNextRetransmit(const ReliableChannel* channel, Uint32* deadline) {
+    bool pending = false;
+    for (int i = 0; i < RELIABLE_WINDOW; i++) {
+        const ReliableMessage* message = &channel->pending[i];
+        if (!message->inUse) continue;
+        int backoff = message->retries < 4 ? message->retries : 4;
+        Uint32 due = message->sentAt + (channel->rto << backoff);
+        if (!pending || (Sint32)(due - *deadline) < 0) *deadline = due;
+        pending = true;
+    }
+    return pending;
+}
@@ -0,0 +1,117 @@
+#include "snapshot_codec.h"
+#include <math.h>
+#include <string.h>
+
+static Uint16 quantizePosition(float value) {
+    if (value <= 0.0f) return 0;
+    if (value >= 65535.0f) return 65535;
+    return (Uint16)(value + 0.5f);
+}
+
+static Sint16 quantizeVelocity(float value) {
+    if (value <= -32767.0f) return -32767;
+    if (value >= 32767.0f) return 32767;
+    return (Sint16)lroundf(value);
+}
+
+static Uint16 quantizeAngle(float degrees) {
+    float turns = fmodf(degrees / 360.0f, 1.0f);
+    if (turns < 0.0f) turns += 1.0f;
+    return (Uint16)((Uint32)(turns * 65536.0f) & 0xFFFF);
+}
+
+int getSnapshotPartCount(int numTanks, int numBullets) {
+    int entities = numTanks + numBullets;
+    int parts = (entities + SNAPSHOT_PART_ENTITIES - 1) / SNAPSHOT_PART_ENTITIES;
+    return parts > 0 ? parts : 1;
+}
+
+int getSnapshotSize(int numTanks, int numBullets) {
+    return getSnapshotPartCount(numTanks, numBullets) * (int)sizeof(SnapshotHeader) +
+           numTanks * (int)sizeof(PackedTank) + numBullets * (int)sizeof(PackedBullet);
+}
+
+int encodeSnapshotPart(Uint8* out, Uint16 sequence, Uint32 serverTime, int part, int partCount,
+                       const TankState* tanks, int numTanks, const BulletState* bullets, int numBullets) {
+    int first = part * SNAPSHOT_PART_ENTITIES;
+    int last = first + SNAPSHOT_PART_ENTITIES;
+    if (last > numTanks + numBullets) last = numTanks + numBullets;
+    int tankEnd = last < numTanks ? last : numTanks;
+    int bulletStart = first > numTanks ? first - numTanks : 0;
+
+    SnapshotHeader header = { GAME_STATE, sequence, serverTime, (Uint8)part, (Uint8)partCount, 0, 0 };
+    int len = sizeof(SnapshotHeader);
+    for (int i = first; i < tankEnd; i++) {
+        PackedTank packed = {
+            .playerNumber = (Uint8)tanks[i].playerNumber,
+            .x = quantizePosition(tanks[i].x),
+            .y = quantizePosition(tanks[i].y),
+            .angle = quantizeAngle(tanks[i].angle),
+            .tankColorId = (Uint8)tanks[i].tankColorId,
+            .health = (Sint8)tanks[i].health
+        };
+        memcpy(out + len, &packed, sizeof(PackedTank));
+        len += sizeof(PackedTank);
+        header.numTanks++;
+    }
+    for (int i = bulletStart; i < last - numTanks; i++) {
+        PackedBullet packed = {
+            .x = quantizePosition(bullets[i].x),
+            .y = quantizePosition(bullets[i].y),
+            .vx = quantizeVelocity(bullets[i].vx),
+            .vy = quantizeVelocity(bullets[i].vy),
+            .ownerId = (Uint8)bullets[i].ownerId
+        };
+        memcpy(out + len, &packed, sizeof(PackedBullet));
+        len += sizeof(PackedBullet);
+        header.numBullets++;
+    }
+    memcpy(out, &header, sizeof(SnapshotHeader));
+    return len;
+}
+
+bool decodeSnapshotPart(const Uint8* data, int len, SnapshotPart* part) {
+    SnapshotHeader header;
+    if (len < (int)sizeof(SnapshotHeader)) return false;
+    memcpy(&header, data, sizeof(SnapshotHeader));
+    if (header.command != GAME_STATE || header.partCount == 0 || header.partCount > SNAPSHOT_MAX_PARTS ||
+        header.part >= header.partCount || header.numTanks + header.numBullets > SNAPSHOT_PART_ENTITIES ||
+        len != (int)sizeof(SnapshotHeader) + header.numTanks * (int)sizeof(PackedTank) + header.numBullets * (int)sizeof(PackedBullet)) {
+        return false;
+    }
+    part->sequence = header.sequence;
+    part->serverTime = header.serverTime;
+    part->part = header.part;
+    part->partCount = header.partCount;
+    part->numTanks = header.numTanks;
+    part->numBullets = header.numBullets;
+    const Uint8* cursor = data + sizeof(SnapshotHeader);
+    for (int i = 0; i < part->numTanks; i++) {
+        PackedTank packed;
+        memcpy(&packed, cursor, sizeof(PackedTank));
+        cursor += sizeof(PackedTank);
+        part->tanks[i] = (TankState){
+            .playerNumber = packed.playerNumber,
+            .x = packed.x,
+            .y = packed.y,
+            .angle = packed.angle * 360.0f / 65536.0f,
+            .tankColorId = packed.tankColorId,
+            .health = packed.health,
+            .shooting = false
+        };
+    }
+    for (int i = 0; i < part->numBullets; i++) {
+        PackedBullet packed;
+        memcpy(&packed, cursor, sizeof(PackedBullet));
+        cursor += sizeof(PackedBullet);
+        part->bullets[i] = (BulletState){
+            .x = packed.x,
+            .y = packed.y,
+            .vx = packed.vx,
+            .vy = packed.vy,
+            .active = true,
+            .ownerId = packed.ownerId
+        };
+    }
+    return true;
+}
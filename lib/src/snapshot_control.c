@@ -0,0 +1,116 @@
+#include "snapshot_control.h"
+#include <string.h>
+
+static bool sequenceBefore(Uint16 a, Uint16 b) {
+    return (Sint16)(a - b) < 0;
+}
+
+static SnapshotRecord* findRecord(SnapshotControl* control, Uint16 sequence) {
+    SnapshotRecord* record = &control->history[sequence % SNAPSHOT_HISTORY];
+    if (!record->sent || record->sequence != sequence) return NULL;
+    return record;
+}
+
+static void applyBudget(SnapshotControl* control) {
+    control->budget.refillPerSecond = control->bytesPerSecond;
+    // Högst en halv sekunds sparade bytes, så att en tyst period inte ger en stor skur
+    control->budget.capacity = control->bytesPerSecond / 2.0f;
+    if (control->budget.tokens > control->budget.capacity) control->budget.tokens = control->budget.capacity;
+}
+
+// Högst en minskning per RTT, annars straffas samma förlustskur flera gånger
+static void onSnapshotLost(SnapshotControl* control, Uint32 now) {
+    control->lossRate = 0.9f * control->lossRate + 0.1f;
+    Uint32 guard = control->hasRtt ? (Uint32)control->smoothedRtt : SNAPSHOT_MIN_INTERVAL;
+    if (now - control->lastDecrease < guard) return;
+    control->lastDecrease = now;
+    control->bytesPerSecond *= 0.75f;
+    if (control->bytesPerSecond < SNAPSHOT_MIN_BYTES_PER_SECOND) control->bytesPerSecond = SNAPSHOT_MIN_BYTES_PER_SECOND;
+    control->interval = control->interval * 5 / 4;
+    if (control->interval > SNAPSHOT_MAX_INTERVAL) control->interval = SNAPSHOT_MAX_INTERVAL;
+    applyBudget(control);
+}
+
+static void onSnapshotDelivered(SnapshotControl* control) {
+    control->lossRate = 0.9f * control->lossRate;
+    // Växande kö syns som stigande RTT innan paketen börjar tappas
+    if (control->hasRtt && control->smoothedRtt > control->minRtt * 1.5f + 20.0f) return;
+    control->bytesPerSecond += SNAPSHOT_BYTES_STEP;
+    if (control->bytesPerSecond > SNAPSHOT_MAX_BYTES_PER_SECOND) control->bytesPerSecond = SNAPSHOT_MAX_BYTES_PER_SECOND;
+    if (control->interval > SNAPSHOT_MIN_INTERVAL) control->interval -= 5;
+    if (control->interval < SNAPSHOT_MIN_INTERVAL) control->interval = SNAPSHOT_MIN_INTERVAL;
+    applyBudget(control);
+}
+
+void initSnapshotControl(SnapshotControl* control, Uint32 now) {
+    memset(control, 0, sizeof(SnapshotControl));
+    // Sekvens 0 är reserverad för "ingen snapshot mottagen än" i klientens kvittens
+    control->nextSequence = 1;
+    control->interval = SNAPSHOT_MIN_INTERVAL;
+    control->lastSent = now - SNAPSHOT_MAX_INTERVAL;
+    control->lastDecrease = now;
+    control->bytesPerSecond = SNAPSHOT_MAX_BYTES_PER_SECOND / 2;
+    initTokenBucket(&control->budget, control->bytesPerSecond / 2.0f, control->bytesPerSecond, now);
+}
+
+bool isSnapshotDue(const SnapshotControl* control, Uint32 now) {
+    return now - control->lastSent >= control->interval;
+}
+
+int getSnapshotAllowance(SnapshotControl* control, Uint32 now) {
+    takeTokens(&control->budget, 0.0f, now);
+    return (int)control->budget.tokens;
+}
+
+Uint16 recordSnapshotSent(SnapshotControl* control, int bytes, Uint32 now) {
+    Uint16 sequence = control->nextSequence++;
+    SnapshotRecord* record = &control->history[sequence % SNAPSHOT_HISTORY];
+    record->sequence = sequence;
+    record->sentAt = now;
+    record->sent = true;
+    record->acked = false;
+    control->lastSent = now;
+    if (!takeTokens(&control->budget, bytes, now)) control->budget.tokens = 0;
+    return sequence;
+}
+
+void handleSnapshotAck(SnapshotControl* control, Uint16 ack, Uint32 ackBits, Uint32 now) {
+    if (!control->hasAck && ack == 0) return;
+    if (control->hasAck && sequenceBefore(ack, control->newestAck)) return;
+    if (!sequenceBefore(ack, control->nextSequence)) return;
+    SnapshotRecord* newest = findRecord(control, ack);
+    if (newest && !newest->acked) {
+        float sample = (float)(now - newest->sentAt);
+        if (!control->hasRtt) {
+            control->smoothedRtt = sample;
+            control->minRtt = sample;
+            control->hasRtt = true;
+        } else {
+            control->smoothedRtt = 0.875f * control->smoothedRtt + 0.125f * sample;
+            if (sample < control->minRtt) control->minRtt = sample;
+        }
+    }
+    for (int i = -1; i < SNAPSHOT_ACK_BITS; i++) {
+        if (i >= 0 && !(ackBits & (1u << i))) continue;
+        SnapshotRecord* record = findRecord(control, (Uint16)(ack - 1 - i));
+        if (record) record->acked = true;
+    }
+    if (!control->hasAck) {
+        control->lossCheckedUpTo = ack;
+        control->hasAck = true;
+    }
+    control->newestAck = ack;
+    // En snapshot räknas som förlorad när tre nyare har kvitterats utan den
+    Uint16 limit = ack - SNAPSHOT_LOSS_THRESHOLD;
+    if (sequenceBefore(control->lossCheckedUpTo, (Uint16)(limit - SNAPSHOT_HISTORY))) {
+        control->lossCheckedUpTo = limit - SNAPSHOT_HISTORY;
+    }
+    while (!sequenceBefore(limit, control->lossCheckedUpTo)) {
+        SnapshotRecord* record = findRecord(control, control->lossCheckedUpTo);
+        if (record) {
+            if (record->acked) onSnapshotDelivered(control);
+            else onSnapshotLost(control, now);
+        }
+        control->lossCheckedUpTo++;
+    }
+}
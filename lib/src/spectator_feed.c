@@ -0,0 +1,96 @@
+#include "spectator_feed.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAME_WRITING -1
+
+typedef struct {
+    SDL_atomic_t number;
+    Uint32 publishedAt;
+    int numParts;
+    int lengths[SPECTATOR_FRAME_PARTS];
+    Uint8 data[SPECTATOR_FRAME_PARTS][SNAPSHOT_PART_SIZE];
+} SpectatorFrame;
+
+// number i varje plats fungerar som seqlock: FRAME_WRITING medan skrivaren håller på, annars bildens nummer
+struct SpectatorFeed {
+    SpectatorFrame* frames;
+    int capacity;
+    SDL_atomic_t head;
+    bool writing;
+};
+
+SpectatorFeed* createSpectatorFeed(int capacity) {
+    if (capacity < 2) return NULL;
+    SpectatorFeed* feed = calloc(1, sizeof(SpectatorFeed));
+    if (!feed) return NULL;
+    feed->frames = calloc(capacity, sizeof(SpectatorFrame));
+    if (!feed->frames) {
+        free(feed);
+        return NULL;
+    }
+    for (int i = 0; i < capacity; i++) {
+        SDL_AtomicSet(&feed->frames[i].number, FRAME_WRITING);
+    }
+    feed->capacity = capacity;
+    return feed;
+}
+
+void destroySpectatorFeed(SpectatorFeed* feed) {
+    if (!feed) return;
+    free(feed->frames);
+    free(feed);
+}
+
+int getSpectatorFeedCapacity(const SpectatorFeed* feed) {
+    return feed->capacity;
+}
+
+Uint8* getSpectatorPartBuffer(SpectatorFeed* feed, int part) {
+    if (part < 0 || part >= SPECTATOR_FRAME_PARTS) return NULL;
+    Uint32 head = (Uint32)SDL_AtomicGet(&feed->head);
+    SpectatorFrame* frame = &feed->frames[head % feed->capacity];
+    // Platsen markeras innan första byten skrivs, så att läsaren inte tar en halvskriven bild för den gamla
+    if (!feed->writing) {
+        SDL_AtomicSet(&frame->number, FRAME_WRITING);
+        feed->writing = true;
+    }
+    return frame->data[part];
+}
+
+void publishSpectatorFrame(SpectatorFeed* feed, const int* lengths, int numParts, Uint32 now) {
+    Uint32 head = (Uint32)SDL_AtomicGet(&feed->head);
+    SpectatorFrame* frame = &feed->frames[head % feed->capacity];
+    if (!feed->writing) SDL_AtomicSet(&frame->number, FRAME_WRITING);
+    feed->writing = false;
+    frame->publishedAt = now;
+    frame->numParts = numParts < SPECTATOR_FRAME_PARTS ? numParts : SPECTATOR_FRAME_PARTS;
+    memcpy(frame->lengths, lengths, frame->numParts * sizeof(int));
+    SDL_AtomicSet(&frame->number, (int)head);
+    SDL_AtomicSet(&feed->head, (int)(head + 1));
+}
+
+Uint32 getSpectatorFeedHead(SpectatorFeed* feed) {
+    return (Uint32)SDL_AtomicGet(&feed->head);
+}
+
+bool peekSpectatorFrame(SpectatorFeed* feed, Uint32 number, Uint32* publishedAt, int* numParts) {
+    SpectatorFrame* frame = &feed->frames[number % feed->capacity];
+    if ((Uint32)SDL_AtomicGet(&frame->number) != number) return false;
+    *publishedAt = frame->publishedAt;
+    *numParts = frame->numParts;
+    SDL_MemoryBarrierAcquire();
+    return (Uint32)SDL_AtomicGet(&frame->number) == number;
+}
+
+bool copySpectatorPart(SpectatorFeed* feed, Uint32 number, int part, Uint8* out, int* len) {
+    SpectatorFrame* frame = &feed->frames[number % feed->capacity];
+    if ((Uint32)SDL_AtomicGet(&frame->number) != number || part < 0 || part >= frame->numParts) return false;
+    int length = frame->lengths[part];
+    if (length <= 0 || length > SNAPSHOT_PART_SIZE) return false;
+    memcpy(out, frame->data[part], length);
+    SDL_MemoryBarrierAcquire();
+    if ((Uint32)SDL_AtomicGet(&frame->number) != number) return false;
+    *len = length;
+    return true;
+}
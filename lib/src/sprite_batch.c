@@ -0,0 +1,164 @@
+#include "sprite_batch.h"
+#include <math.h>
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define ATLAS_WIDTH 520
+#define ATLAS_HEIGHT 164
+#define BATCH_INITIAL_SPRITES 64
+
+struct SpriteBatch {
+    SDL_Texture* atlas;
+    SDL_Vertex* vertices;
+    int* indices;
+    int count;
+    int capacity;
+    float offsetX, offsetY;
+};
+
+static const char* spritePaths[SPRITE_COUNT] = {
+    "../lib/resources/tank.png",
+    "../lib/resources/tank_lego.png",
+    "../lib/resources/tank_light.png",
+    "../lib/resources/tank_dark.png",
+    "../lib/resources/bullet.png",
+    "../lib/resources/heart.png"
+};
+
+// 2 px tomrum mellan cellerna så att linjär filtrering inte blöder in grannen
+static const SDL_Rect spriteCells[SPRITE_COUNT] = {
+    {0, 0, 128, 128},
+    {130, 0, 128, 128},
+    {260, 0, 128, 128},
+    {390, 0, 128, 128},
+    {0, 130, 32, 32},
+    {34, 130, 32, 32}
+};
+
+static SDL_Texture* buildAtlas(SDL_Renderer* renderer, SDL_Surface* sprites[SPRITE_COUNT]) {
+    SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, ATLAS_WIDTH, ATLAS_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!atlasSurface) {
+        SDL_Log("Kunde inte skapa atlas-yta: %s", SDL_GetError());
+        return NULL;
+    }
+    SDL_FillRect(atlasSurface, NULL, 0);
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        if (!sprites[i]) continue;
+        SDL_Rect cell = spriteCells[i];
+        SDL_SetSurfaceBlendMode(sprites[i], SDL_BLENDMODE_NONE);
+        SDL_BlitScaled(sprites[i], NULL, atlasSurface, &cell);
+    }
+    SDL_Texture* atlas = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+    SDL_FreeSurface(atlasSurface);
+    if (!atlas) {
+        SDL_Log("Kunde inte skapa atlas-texture: %s", SDL_GetError());
+        return NULL;
+    }
+    SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+    return atlas;
+}
+
+static bool reserveSprites(SpriteBatch* batch, int needed) {
+    if (needed <= batch->capacity) return true;
+    int capacity = batch->capacity ? batch->capacity : BATCH_INITIAL_SPRITES;
+    while (capacity < needed) capacity *= 2;
+    SDL_Vertex* vertices = realloc(batch->vertices, sizeof(SDL_Vertex) * 4 * capacity);
+    if (!vertices) return false;
+    batch->vertices = vertices;
+    int* indices = realloc(batch->indices, sizeof(int) * 6 * capacity);
+    if (!indices) return false;
+    batch->indices = indices;
+    for (int i = batch->capacity; i < capacity; i++) {
+        int base = i * 4;
+        indices[i * 6 + 0] = base;
+        indices[i * 6 + 1] = base + 1;
+        indices[i * 6 + 2] = base + 2;
+        indices[i * 6 + 3] = base;
+        indices[i * 6 + 4] = base + 2;
+        indices[i * 6 + 5] = base + 3;
+    }
+    batch->capacity = capacity;
+    return true;
+}
+
+SpriteBatch* createSpriteBatch(SDL_Renderer* renderer, SDL_Surface* sprites[SPRITE_COUNT]) {
+    SpriteBatch* batch = calloc(1, sizeof(SpriteBatch));
+    if (!batch) return NULL;
+    batch->atlas = buildAtlas(renderer, sprites);
+    if (!batch->atlas || !reserveSprites(batch, BATCH_INITIAL_SPRITES)) {
+        destroySpriteBatch(batch);
+        return NULL;
+    }
+    return batch;
+}
+
+void destroySpriteBatch(SpriteBatch* batch) {
+    if (!batch) return;
+    if (batch->atlas) SDL_DestroyTexture(batch->atlas);
+    free(batch->vertices);
+    free(batch->indices);
+    free(batch);
+}
+
+const char* getSpritePath(SpriteId id) {
+    if (id < 0 || id >= SPRITE_COUNT) return NULL;
+    return spritePaths[id];
+}
+
+SpriteId getTankSprite(int colorId) {
+    if (colorId < 0 || colorId > SPRITE_TANK_SHADOW_REAPER) return SPRITE_TANK_IRONCLAD;
+    return (SpriteId)colorId;
+}
+
+void addSprite(SpriteBatch* batch, SpriteId id, const SDL_FRect* dst, float angle) {
+    if (!batch || id < 0 || id >= SPRITE_COUNT) return;
+    if (!reserveSprites(batch, batch->count + 1)) return;
+
+    const SDL_Rect* cell = &spriteCells[id];
+    float u0 = (float)cell->x / ATLAS_WIDTH;
+    float v0 = (float)cell->y / ATLAS_HEIGHT;
+    float u1 = (float)(cell->x + cell->w) / ATLAS_WIDTH;
+    float v1 = (float)(cell->y + cell->h) / ATLAS_HEIGHT;
+
+    float halfW = dst->w / 2.0f;
+    float halfH = dst->h / 2.0f;
+    float centerX = dst->x - batch->offsetX + halfW;
+    float centerY = dst->y - batch->offsetY + halfH;
+    float cosA = 1.0f, sinA = 0.0f;
+    if (angle != 0.0f) {
+        float radians = angle * M_PI / 180.0f;
+        cosA = cosf(radians);
+        sinA = sinf(radians);
+    }
+    const float cornerX[4] = {-halfW, halfW, halfW, -halfW};
+    const float cornerY[4] = {-halfH, -halfH, halfH, halfH};
+    const float cornerU[4] = {u0, u1, u1, u0};
+    const float cornerV[4] = {v0, v0, v1, v1};
+
+    SDL_Vertex* v = &batch->vertices[batch->count * 4];
+    for (int i = 0; i < 4; i++) {
+        v[i].position.x = centerX + cornerX[i] * cosA - cornerY[i] * sinA;
+        v[i].position.y = centerY + cornerX[i] * sinA + cornerY[i] * cosA;
+        v[i].color = (SDL_Color){255, 255, 255, 255};
+        v[i].tex_coord.x = cornerU[i];
+        v[i].tex_coord.y = cornerV[i];
+    }
+    batch->count++;
+}
+
+void setSpriteOffset(SpriteBatch* batch, float x, float y) {
+    if (!batch) return;
+    batch->offsetX = x;
+    batch->offsetY = y;
+}
+
+void flushSpriteBatch(SpriteBatch* batch, SDL_Renderer* renderer) {
+    if (!batch || batch->count == 0) return;
+    if (SDL_RenderGeometry(renderer, batch->atlas, batch->vertices, batch->count * 4, batch->indices, batch->count * 6) != 0) {
+        SDL_Log("SDL_RenderGeometry: %s", SDL_GetError());
+    }
+    batch->count = 0;
+}
@@ -0,0 +1,61 @@
+#include "spsc_queue.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_LINE 64
+
+// head skrivs bara av konsumenten och tail bara av producenten; de ligger på var sin cachelinje
+struct SpscQueue {
+    SDL_atomic_t head;
+    char headPadding[CACHE_LINE - sizeof(SDL_atomic_t)];
+    SDL_atomic_t tail;
+    char tailPadding[CACHE_LINE - sizeof(SDL_atomic_t)];
+    Uint8* slots;
+    int elementSize;
+    Uint32 mask;
+};
+
+SpscQueue* createSpscQueue(int capacity, int elementSize) {
+    if (capacity <= 0 || elementSize <= 0) return NULL;
+    Uint32 size = 1;
+    while (size < (Uint32)capacity) size <<= 1;
+    SpscQueue* queue = calloc(1, sizeof(SpscQueue));
+    if (!queue) return NULL;
+    queue->slots = malloc((size_t)size * elementSize);
+    if (!queue->slots) {
+        free(queue);
+        return NULL;
+    }
+    queue->elementSize = elementSize;
+    queue->mask = size - 1;
+    return queue;
+}
+
+void destroySpscQueue(SpscQueue* queue) {
+    if (!queue) return;
+    free(queue->slots);
+    free(queue);
+}
+
+bool pushSpscQueue(SpscQueue* queue, const void* element) {
+    Uint32 tail = (Uint32)SDL_AtomicGet(&queue->tail);
+    Uint32 head = (Uint32)SDL_AtomicGet(&queue->head);
+    if (tail - head > queue->mask) return false;
+    memcpy(queue->slots + (size_t)(tail & queue->mask) * queue->elementSize, element, queue->elementSize);
+    // Elementet ska synas för konsumenten innan tail gör det
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&queue->tail, (int)(tail + 1));
+    return true;
+}
+
+bool popSpscQueue(SpscQueue* queue, void* element) {
+    Uint32 head = (Uint32)SDL_AtomicGet(&queue->head);
+    Uint32 tail = (Uint32)SDL_AtomicGet(&queue->tail);
+    if (head == tail) return false;
+    SDL_MemoryBarrierAcquire();
+    memcpy(element, queue->slots + (size_t)(head & queue->mask) * queue->elementSize, queue->elementSize);
+    // Platsen får inte skrivas över förrän den är utläst
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&queue->head, (int)(head + 1));
+    return true;
+}
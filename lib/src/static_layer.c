@@ -0,0 +1,70 @@
+#include "static_layer.h"
+#include <stdlib.h>
+
+// 2048 x 2048 x 4 bytes = 16 MB; större världar ritas direkt i stället
+#define STATIC_LAYER_MAX_SIZE 2048
+
+struct StaticLayer {
+    SDL_Texture* texture;
+    int width;
+    int height;
+};
+
+StaticLayer* createStaticLayer(SDL_Renderer* renderer, int worldWidth, int worldHeight) {
+    if (!SDL_RenderTargetSupported(renderer)) return NULL;
+    int maxWidth = STATIC_LAYER_MAX_SIZE, maxHeight = STATIC_LAYER_MAX_SIZE;
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0) {
+        if (info.max_texture_width > 0 && info.max_texture_width < maxWidth) maxWidth = info.max_texture_width;
+        if (info.max_texture_height > 0 && info.max_texture_height < maxHeight) maxHeight = info.max_texture_height;
+    }
+    if (worldWidth > maxWidth || worldHeight > maxHeight) return NULL;
+
+    StaticLayer* layer = malloc(sizeof(StaticLayer));
+    if (!layer) return NULL;
+    layer->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, worldWidth, worldHeight);
+    if (!layer->texture) {
+        SDL_Log("Kunde inte skapa statiskt lager: %s", SDL_GetError());
+        free(layer);
+        return NULL;
+    }
+    SDL_SetTextureBlendMode(layer->texture, SDL_BLENDMODE_NONE);
+    layer->width = worldWidth;
+    layer->height = worldHeight;
+    return layer;
+}
+
+void destroyStaticLayer(StaticLayer* layer) {
+    if (!layer) return;
+    if (layer->texture) SDL_DestroyTexture(layer->texture);
+    free(layer);
+}
+
+bool buildStaticLayer(StaticLayer* layer, SDL_Renderer* renderer, SDL_Texture* background, int tileWidth, int tileHeight,
+                      Wall* walls[], int numWalls) {
+    if (!layer) return false;
+    if (SDL_SetRenderTarget(renderer, layer->texture) != 0) {
+        SDL_Log("SDL_SetRenderTarget: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    if (background) {
+        for (int y = 0; y < layer->height; y += tileHeight) {
+            for (int x = 0; x < layer->width; x += tileWidth) {
+                SDL_Rect dst = { x, y, tileWidth, tileHeight };
+                SDL_RenderCopy(renderer, background, NULL, &dst);
+            }
+        }
+    }
+    for (int i = 0; i < numWalls; i++) {
+        if (walls[i]) renderWall(renderer, walls[i], 0, 0);
+    }
+    SDL_SetRenderTarget(renderer, NULL);
+    return true;
+}
+
+void renderStaticLayer(StaticLayer* layer, SDL_Renderer* renderer, int cameraX, int cameraY, int viewWidth, int viewHeight) {
+    SDL_Rect src = { cameraX, cameraY, viewWidth, viewHeight };
+    SDL_RenderCopy(renderer, layer->texture, &src, NULL);
+}
@@ -0,0 +1,229 @@
+#include "stats_log.h"
+#include "spsc_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define syncFile(file) _commit(_fileno(file))
+#define truncateFile(file, size) _chsize_s(_fileno(file), size)
+#else
+#include <unistd.h>
+#define syncFile(file) fsync(fileno(file))
+#define truncateFile(file, size) ftruncate(fileno(file), size)
+#endif
+
+#define STATS_MAGIC "RTSTAT\x01\0"
+#define STATS_MAGIC_SIZE 8
+#define STATS_MATCH_RECORD 18
+#define STATS_PLAYER_RECORD 18
+#define STATS_QUEUE_SIZE 64
+#define STATS_POLL_MS 100
+#define STATS_SYNC_INTERVAL_MS 1000
+
+struct StatsWriter {
+    FILE* file;
+    SpscQueue* queue;
+    SDL_Thread* thread;
+    SDL_atomic_t running;
+};
+
+struct StatsReader {
+    FILE* file;
+};
+
+static void writeMatchResult(FILE* file, const MatchResult* result) {
+    Uint8 record[STATS_MATCH_RECORD];
+    SDLNet_Write32((Uint32)((Uint64)result->endedAt >> 32), record);
+    SDLNet_Write32((Uint32)result->endedAt, record + 4);
+    SDLNet_Write32(result->round, record + 8);
+    SDLNet_Write32(result->durationMs, record + 12);
+    record[16] = result->winningPlayerID;
+    record[17] = (Uint8)result->numPlayers;
+    fwrite(record, 1, STATS_MATCH_RECORD, file);
+    for (int i = 0; i < result->numPlayers; i++) {
+        const PlayerResult* player = &result->players[i];
+        Uint8 entry[STATS_PLAYER_RECORD];
+        // host och port ligger redan i nätverksordning i IPaddress
+        memcpy(entry, &player->address.host, 4);
+        memcpy(entry + 4, &player->address.port, 2);
+        entry[6] = player->playerID;
+        entry[7] = player->tankColorId;
+        SDLNet_Write16(player->shots, entry + 8);
+        SDLNet_Write16(player->hits, entry + 10);
+        SDLNet_Write16(player->damageTaken, entry + 12);
+        SDLNet_Write32(player->aliveMs, entry + 14);
+        fwrite(entry, 1, STATS_PLAYER_RECORD, file);
+    }
+}
+
+// Allt disk-I/O sker här; stdio-bufferten samlar posterna och fsync görs högst en gång per intervall
+static int statsWriterThread(void* data) {
+    StatsWriter* writer = data;
+    static MatchResult result;
+    Uint32 lastSync = SDL_GetTicks();
+    bool unsynced = false;
+    while (true) {
+        bool stopping = !SDL_AtomicGet(&writer->running);
+        while (popSpscQueue(writer->queue, &result)) {
+            writeMatchResult(writer->file, &result);
+            unsynced = true;
+        }
+        Uint32 now = SDL_GetTicks();
+        if (unsynced && (stopping || now - lastSync >= STATS_SYNC_INTERVAL_MS)) {
+            if (fflush(writer->file) != 0 || syncFile(writer->file) != 0) {
+                SDL_Log("Kunde inte synka statistikfilen");
+            }
+            lastSync = now;
+            unsynced = false;
+        }
+        if (stopping) break;
+        SDL_Delay(STATS_POLL_MS);
+    }
+    return 0;
+}
+
+static bool readRecord(FILE* file, MatchResult* out) {
+    Uint8 record[STATS_MATCH_RECORD];
+    if (fread(record, 1, STATS_MATCH_RECORD, file) != STATS_MATCH_RECORD) return false;
+    out->endedAt = (Sint64)(((Uint64)SDLNet_Read32(record) << 32) | SDLNet_Read32(record + 4));
+    out->round = SDLNet_Read32(record + 8);
+    out->durationMs = SDLNet_Read32(record + 12);
+    out->winningPlayerID = record[16];
+    out->numPlayers = record[17];
+    if (out->numPlayers > MAX_PLAYERS) {
+        SDL_Log("Trasig statistikpost (%d spelare)", out->numPlayers);
+        return false;
+    }
+    for (int i = 0; i < out->numPlayers; i++) {
+        PlayerResult* player = &out->players[i];
+        Uint8 entry[STATS_PLAYER_RECORD];
+        if (fread(entry, 1, STATS_PLAYER_RECORD, file) != STATS_PLAYER_RECORD) return false;
+        memcpy(&player->address.host, entry, 4);
+        memcpy(&player->address.port, entry + 4, 2);
+        player->playerID = entry[6];
+        player->tankColorId = entry[7];
+        player->shots = SDLNet_Read16(entry + 8);
+        player->hits = SDLNet_Read16(entry + 10);
+        player->damageTaken = SDLNet_Read16(entry + 12);
+        player->aliveMs = SDLNet_Read32(entry + 14);
+    }
+    return true;
+}
+
+static bool hasStatsMagic(FILE* file) {
+    char magic[STATS_MAGIC_SIZE];
+    return fread(magic, 1, STATS_MAGIC_SIZE, file) == STATS_MAGIC_SIZE &&
+           memcmp(magic, STATS_MAGIC, STATS_MAGIC_SIZE) == 0;
+}
+
+// Klipper bort en halvskriven post i slutet, annars hamnar allt som skrivs efter den ur fas.
+// Returnerar filens storlek efteråt, eller -1 om den inte är en statistikfil.
+static long repairStatsFile(FILE* file) {
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    if (size == 0) return 0;
+    fseek(file, 0, SEEK_SET);
+    if (size < STATS_MAGIC_SIZE) {
+        // Kraschen kom redan medan headern skrevs
+        char prefix[STATS_MAGIC_SIZE];
+        if (fread(prefix, 1, size, file) != (size_t)size || memcmp(prefix, STATS_MAGIC, size) != 0) return -1;
+        fflush(file);
+        return truncateFile(file, 0) == 0 ? 0 : -1;
+    }
+    if (!hasStatsMagic(file)) return -1;
+    static MatchResult record;
+    long complete = ftell(file);
+    while (readRecord(file, &record)) complete = ftell(file);
+    if (complete < size) {
+        SDL_Log("Statistikfilen slutar med en ofullständig post, %ld bytes tas bort", size - complete);
+        fflush(file);
+        if (truncateFile(file, complete) != 0) return -1;
+    }
+    return complete;
+}
+
+StatsWriter* createStatsWriter(const char* path) {
+    // En befintlig fil fortsätts, men bara om den verkligen är en statistikfil
+    long size = 0;
+    FILE* existing = fopen(path, "rb+");
+    if (existing) {
+        size = repairStatsFile(existing);
+        fclose(existing);
+        if (size < 0) {
+            SDL_Log("%s är ingen statistikfil", path);
+            return NULL;
+        }
+    }
+    StatsWriter* writer = calloc(1, sizeof(StatsWriter));
+    if (!writer) return NULL;
+    writer->file = fopen(path, "ab");
+    writer->queue = createSpscQueue(STATS_QUEUE_SIZE, sizeof(MatchResult));
+    if (!writer->file || !writer->queue) {
+        SDL_Log("Kunde inte öppna statistikfilen %s", path);
+        if (writer->file) fclose(writer->file);
+        destroySpscQueue(writer->queue);
+        free(writer);
+        return NULL;
+    }
+    setvbuf(writer->file, NULL, _IOFBF, 1 << 16);
+    if (size == 0) {
+        fwrite(STATS_MAGIC, 1, STATS_MAGIC_SIZE, writer->file);
+    }
+    SDL_AtomicSet(&writer->running, 1);
+    writer->thread = SDL_CreateThread(statsWriterThread, "statsWriter", writer);
+    if (!writer->thread) {
+        SDL_Log("SDL_CreateThread: %s", SDL_GetError());
+        fclose(writer->file);
+        destroySpscQueue(writer->queue);
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+bool submitMatchResult(StatsWriter* writer, const MatchResult* result) {
+    if (!writer) return false;
+    return pushSpscQueue(writer->queue, result);
+}
+
+void destroyStatsWriter(StatsWriter* writer) {
+    if (!writer) return;
+    SDL_AtomicSet(&writer->running, 0);
+    SDL_WaitThread(writer->thread, NULL);
+    fclose(writer->file);
+    destroySpscQueue(writer->queue);
+    free(writer);
+}
+
+StatsReader* openStatsReader(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        SDL_Log("Kunde inte öppna statistikfilen %s", path);
+        return NULL;
+    }
+    if (!hasStatsMagic(file)) {
+        SDL_Log("%s är ingen statistikfil", path);
+        fclose(file);
+        return NULL;
+    }
+    StatsReader* reader = calloc(1, sizeof(StatsReader));
+    if (!reader) {
+        fclose(file);
+        return NULL;
+    }
+    reader->file = file;
+    return reader;
+}
+
+// En post som bara delvis hann skrivas före en krasch räknas som filens slut
+bool readMatchResult(StatsReader* reader, MatchResult* out) {
+    return readRecord(reader->file, out);
+}
+
+void closeStatsReader(StatsReader* reader) {
+    if (!reader) return;
+    fclose(reader->file);
+    free(reader);
+}
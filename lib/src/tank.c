@@ -8,9 +8,6 @@
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
 
-static SDL_Texture* tankTexture = NULL;
-static SDL_Texture* heartTexture = NULL;
-
 struct Tank {
     SDL_Rect rect;
     float velocityX;
@@ -21,17 +18,25 @@ struct Tank {
     bool alive;
 };
 
+static void initTank(Tank* tank) {
+    tank->rect = (SDL_Rect){0, 0, 64, 64};
+    tank->velocityX = 0;
+    tank->velocityY = 0;
+    tank->angle = 0;
+    tank->health = 3;
+    tank->alive = true;
+    tank->colorId = 0;
+}
+
 Tank* createTank(void) {
     Tank* tank = malloc(sizeof(Tank));
-    if (tank) {
-        tank->rect = (SDL_Rect){0, 0, 64, 64};
-        tank->velocityX = 0;
-        tank->velocityY = 0;
-        tank->angle = 0;
-        tank->health = 3;
-        tank->alive = true;
-        tank->colorId = 0;
-    }
+    if (tank) initTank(tank);
+    return tank;
+}
+
+Tank* createTankInArena(Arena* arena) {
+    Tank* tank = arenaAlloc(arena, sizeof(Tank));
+    if (tank) initTank(tank);
     return tank;
 }
 
@@ -84,51 +89,16 @@ float getTankAngle(const Tank* tank) {
     return tank ? tank->angle : 0.0f;
 }
 
-void initTank(SDL_Renderer* renderer) {
-    tankTexture = IMG_LoadTexture(renderer, "../lib/resources/tank.png");
-    if (!tankTexture) {
-        SDL_Log("Kunde inte ladda tank.png: %s", IMG_GetError());
-    }
-}
-
-void drawTank(SDL_Renderer* renderer, Tank* tank, SDL_Texture* tankTexture) {
-    if (!tankTexture || !tank) return;
-    SDL_RenderCopyEx(renderer, tankTexture, NULL, &tank->rect, tank->angle, NULL, SDL_FLIP_NONE);
+void drawTank(SpriteBatch* batch, Tank* tank) {
+    if (!tank) return;
+    SDL_FRect dst = {tank->rect.x, tank->rect.y, tank->rect.w, tank->rect.h};
+    addSprite(batch, getTankSprite(tank->colorId), &dst, tank->angle);
 }
 
-void loadHeartTexture(SDL_Renderer* renderer) {
-    SDL_Surface* surface = IMG_Load("../lib/resources/heart.png");
-    if (!surface) {
-        SDL_Log("Kunde inte ladda heart.png: %s", IMG_GetError());
-        return;
-    }
-    heartTexture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FreeSurface(surface);
-    if (!heartTexture) {
-        SDL_Log("Kunde inte skapa heart-texture: %s", SDL_GetError());
-    }
-}
-
-void destroyHeartTexture(void) {
-    if (heartTexture) {
-        SDL_DestroyTexture(heartTexture);
-        heartTexture = NULL;
-    }
-}
-
-void renderTankHealth(SDL_Renderer* renderer, int health) {
-    if (!heartTexture) return;
-
-    SDL_Rect heartRect = {0, 10, 32, 32};  // uppe på skärmen
+void renderTankHealth(SpriteBatch* batch, int health) {
+    SDL_FRect heartRect = {0, 10, 32, 32};  // uppe på skärmen
     for (int i = 0; i < health; i++) {
         heartRect.x = 800 - (i + 1) * 40;  // 760, 720, 680
-        SDL_RenderCopy(renderer, heartTexture, NULL, &heartRect);
-    }
-}
-
-void destroyTank(void) {
-    if (tankTexture) {
-        SDL_DestroyTexture(tankTexture);
-        tankTexture = NULL;
+        addSprite(batch, SPRITE_HEART, &heartRect, 0.0f);
     }
 }
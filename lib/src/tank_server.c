@@ -9,13 +9,23 @@ struct Tank {
     int colorId;
 };
 
-Tank* createTank() {
-    Tank* tank = malloc(sizeof(Tank));
+static void initTank(Tank* tank) {
     tank->x = 0;
     tank->y = 0;
     tank->angle = 0.0f;
     tank->health = 3;
     tank->colorId = 0;
+}
+
+Tank* createTank() {
+    Tank* tank = malloc(sizeof(Tank));
+    if (tank) initTank(tank);
+    return tank;
+}
+
+Tank* createTankInArena(Arena* arena) {
+    Tank* tank = arenaAlloc(arena, sizeof(Tank));
+    if (tank) initTank(tank);
     return tank;
 }
 
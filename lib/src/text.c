@@ -1,6 +1,11 @@
 #include "text.h"
 
+#define SMALL_FONT_SIZE 14
+
 static TTF_Font* font = NULL;
+static TTF_Font* smallFont = NULL;
+static void* fontData = NULL;
+static size_t fontDataSize = 0;
 
 void initTextSystem(const char* fontPath, int fontSize) {
     if (TTF_Init() == -1) {
@@ -11,12 +16,33 @@ void initTextSystem(const char* fontPath, int fontSize) {
     if (!font) {
         SDL_Log("Failed to load font %s: %s", fontPath, TTF_GetError());
     }
+    smallFont = TTF_OpenFont(fontPath, SMALL_FONT_SIZE);
 }
 
-void renderText(SDL_Renderer* renderer, const char* text, int x, int y, SDL_Color color) {
-    if (!font) return;
+void initTextSystemFromMemory(void* data, size_t size, int fontSize) {
+    if (TTF_Init() == -1) {
+        SDL_Log("TTF_Init Error: %s", TTF_GetError());
+        SDL_free(data);
+        return;
+    }
+    fontData = data;
+    fontDataSize = size;
+    font = openTextFont(fontSize);
+    if (!font) {
+        SDL_Log("Failed to load font from memory: %s", TTF_GetError());
+    }
+    smallFont = openTextFont(SMALL_FONT_SIZE);
+}
 
-    SDL_Surface* surface = TTF_RenderText_Blended(font, text, color);
+TTF_Font* openTextFont(int fontSize) {
+    if (!fontData) return TTF_OpenFont("../lib/resources/Orbitron-Bold.ttf", fontSize);
+    return TTF_OpenFontRW(SDL_RWFromConstMem(fontData, (int)fontDataSize), 1, fontSize);
+}
+
+static void renderTextWithFont(SDL_Renderer* renderer, TTF_Font* textFont, const char* text, int x, int y, SDL_Color color) {
+    if (!textFont) return;
+
+    SDL_Surface* surface = TTF_RenderText_Blended(textFont, text, color);
     if (!surface) {
         SDL_Log("Text Surface Error: %s", TTF_GetError());
         return;
@@ -36,10 +62,27 @@ void renderText(SDL_Renderer* renderer, const char* text, int x, int y, SDL_Colo
     SDL_DestroyTexture(texture);
 }
 
+void renderText(SDL_Renderer* renderer, const char* text, int x, int y, SDL_Color color) {
+    renderTextWithFont(renderer, font, text, x, y, color);
+}
+
+void renderSmallText(SDL_Renderer* renderer, const char* text, int x, int y, SDL_Color color) {
+    renderTextWithFont(renderer, smallFont, text, x, y, color);
+}
+
 void closeTextSystem(void) {
     if (font) {
         TTF_CloseFont(font);
         font = NULL;
     }
+    if (smallFont) {
+        TTF_CloseFont(smallFont);
+        smallFont = NULL;
+    }
+    if (fontData) {
+        SDL_free(fontData);
+        fontData = NULL;
+        fontDataSize = 0;
+    }
     TTF_Quit();
 }
@@ -2,14 +2,14 @@
 
 void initiate_timer(Timer* timer)                                           
 {
-    timer->last_time = SDL_GetTicks();                                      
+    timer->last_time = SDL_GetPerformanceCounter();                         
     timer->delta_time = 0.0f;                                               
 }
 
 void update_timer(Timer* timer)                                             
 {
-    Uint32 current_time = SDL_GetTicks();                                   
-    timer->delta_time = (current_time - timer->last_time) / 1000.0f;        
+    Uint64 current_time = SDL_GetPerformanceCounter();                      
+    timer->delta_time = (float)((double)(current_time - timer->last_time) / SDL_GetPerformanceFrequency());
     timer->last_time = current_time;                                        
 
     if(timer->delta_time > 0.05f)                                           
@@ -21,4 +21,4 @@ void update_timer(Timer* timer)
 float get_timer(Timer* timer)                                               
 {
     return timer->delta_time;                                              
-}
\ No newline at end of file
+}
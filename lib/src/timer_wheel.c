@@ -0,0 +1,112 @@
+#include "timer_wheel.h"
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_MAX_DELTA ((Uint32)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+static void linkEntry(TimerEntry* head, TimerEntry* entry) {
+    entry->prev = head->prev;
+    entry->next = head;
+    head->prev->next = entry;
+    head->prev = entry;
+}
+
+static void unlinkEntry(TimerEntry* entry) {
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    entry->next = NULL;
+    entry->prev = NULL;
+}
+
+// Nivå väljs efter hur långt bort timern ligger; slot efter motsvarande bitar i utgångstiden
+static void addEntry(TimerWheel* wheel, TimerEntry* entry) {
+    Uint32 delta = entry->expires - wheel->currentTick;
+    if ((Sint32)delta < 0) {
+        entry->expires = wheel->currentTick;
+        delta = 0;
+    } else if (delta >= TIMER_WHEEL_MAX_DELTA) {
+        entry->expires = wheel->currentTick + TIMER_WHEEL_MAX_DELTA - 1;
+        delta = TIMER_WHEEL_MAX_DELTA - 1;
+    }
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= ((Uint32)1 << (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    int slot = (entry->expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    linkEntry(&wheel->slots[level][slot], entry);
+}
+
+// Flyttar ner en slot från nivån ovanför; returnerar slot-index så att anroparen vet om nästa nivå också ska kaskaderas
+static int cascade(TimerWheel* wheel, int level) {
+    int slot = (wheel->currentTick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    TimerEntry* head = &wheel->slots[level][slot];
+    while (head->next != head) {
+        TimerEntry* entry = head->next;
+        unlinkEntry(entry);
+        addEntry(wheel, entry);
+    }
+    return slot;
+}
+
+void initTimerWheel(TimerWheel* wheel, Uint32 now, Uint32 resolutionMs) {
+    wheel->resolution = resolutionMs ? resolutionMs : 1;
+    wheel->currentTick = now / wheel->resolution;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            wheel->slots[level][slot].next = &wheel->slots[level][slot];
+            wheel->slots[level][slot].prev = &wheel->slots[level][slot];
+        }
+    }
+}
+
+void initTimerEntry(TimerEntry* entry, TimerCallback callback, void* userData) {
+    entry->next = NULL;
+    entry->prev = NULL;
+    entry->expires = 0;
+    entry->callback = callback;
+    entry->userData = userData;
+}
+
+void scheduleTimer(TimerWheel* wheel, TimerEntry* entry, Uint32 expiresAt) {
+    if (entry->next) unlinkEntry(entry);
+    // Avrunda uppåt så att en timer aldrig går före sin utgångstid
+    entry->expires = (expiresAt + wheel->resolution - 1) / wheel->resolution;
+    addEntry(wheel, entry);
+}
+
+void cancelTimer(TimerEntry* entry) {
+    if (entry->next) unlinkEntry(entry);
+}
+
+bool isTimerScheduled(const TimerEntry* entry) {
+    return entry->next != NULL;
+}
+
+void advanceTimerWheel(TimerWheel* wheel, Uint32 now) {
+    Uint32 target = now / wheel->resolution;
+    while ((Sint32)(target - wheel->currentTick) >= 0) {
+        int slot = wheel->currentTick & TIMER_WHEEL_MASK;
+        if (slot == 0) {
+            for (int level = 1; level < TIMER_WHEEL_LEVELS && cascade(wheel, level) == 0; level++) {
+            }
+        }
+        // Lyft ur listan först: callbacks som schemalägger om hamnar då på nästa tick, inte i samma varv
+        TimerEntry expired;
+        TimerEntry* head = &wheel->slots[0][slot];
+        if (head->next == head) {
+            wheel->currentTick++;
+            continue;
+        }
+        expired.next = head->next;
+        expired.prev = head->prev;
+        expired.next->prev = &expired;
+        expired.prev->next = &expired;
+        head->next = head;
+        head->prev = head;
+        wheel->currentTick++;
+        while (expired.next != &expired) {
+            TimerEntry* entry = expired.next;
+            unlinkEntry(entry);
+            if (entry->callback) entry->callback(entry, now);
+        }
+    }
+}
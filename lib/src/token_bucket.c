@@ -0,0 +1,20 @@
+#include "token_bucket.h"
+
+void initTokenBucket(TokenBucket* bucket, float capacity, float refillPerSecond, Uint32 now) {
+    bucket->tokens = capacity;
+    bucket->capacity = capacity;
+    bucket->refillPerSecond = refillPerSecond;
+    bucket->lastRefill = now;
+}
+
+bool takeTokens(TokenBucket* bucket, float amount, Uint32 now) {
+    Uint32 elapsed = now - bucket->lastRefill;
+    if (elapsed > 0) {
+        bucket->tokens += elapsed * bucket->refillPerSecond / 1000.0f;
+        if (bucket->tokens > bucket->capacity) bucket->tokens = bucket->capacity;
+        bucket->lastRefill = now;
+    }
+    if (bucket->tokens < amount) return false;
+    bucket->tokens -= amount;
+    return true;
+}
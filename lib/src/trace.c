@@ -0,0 +1,114 @@
+#include "trace.h"
+
+#ifdef TRACE_ENABLED
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TRACE_RING_SIZE 16384
+
+#define TRACE_THREAD_LOCAL _Thread_local
+
+typedef struct {
+    const char* name;
+    Uint64 start;
+    Uint64 end;
+} TraceEvent;
+
+typedef struct TraceRing {
+    TraceEvent events[TRACE_RING_SIZE];
+    SDL_atomic_t head;
+    SDL_atomic_t full;
+    int threadId;
+    const char* threadName;
+    struct TraceRing* next;
+} TraceRing;
+
+static TRACE_THREAD_LOCAL TraceRing* localRing = NULL;
+static TraceRing* rings = NULL;
+static SDL_SpinLock ringsLock = 0;
+static int nextThreadId = 1;
+
+// Bara första händelsen på en tråd tar låset, sedan skriver varje tråd i sin egen ring
+static TraceRing* getLocalRing(void) {
+    if (localRing) return localRing;
+    TraceRing* ring = calloc(1, sizeof(TraceRing));
+    if (!ring) return NULL;
+    SDL_AtomicLock(&ringsLock);
+    ring->threadId = nextThreadId++;
+    ring->next = rings;
+    rings = ring;
+    SDL_AtomicUnlock(&ringsLock);
+    localRing = ring;
+    return ring;
+}
+
+void traceEndScope(TraceScope* scope) {
+    Uint64 end = SDL_GetPerformanceCounter();
+    TraceRing* ring = getLocalRing();
+    if (!ring) return;
+    int head = SDL_AtomicGet(&ring->head);
+    TraceEvent* event = &ring->events[head];
+    event->name = scope->name;
+    event->start = scope->start;
+    event->end = end;
+    if (++head == TRACE_RING_SIZE) {
+        head = 0;
+        SDL_AtomicSet(&ring->full, 1);
+    }
+    SDL_AtomicSet(&ring->head, head);
+}
+
+void traceSetThreadName(const char* name) {
+    TraceRing* ring = getLocalRing();
+    if (ring) ring->threadName = name;
+}
+
+// Händelser som skrivs över under exporten kan bli trasiga, så anropa helst i ett lugnt läge
+bool traceWriteJson(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        SDL_Log("Kunde inte öppna %s för trace-export", path);
+        return false;
+    }
+    double usPerTick = 1000000.0 / SDL_GetPerformanceFrequency();
+    bool first = true;
+    int written = 0;
+    SDL_AtomicLock(&ringsLock);
+    TraceRing* allRings = rings;
+    SDL_AtomicUnlock(&ringsLock);
+    Uint64 epoch = 0;
+    for (TraceRing* ring = allRings; ring; ring = ring->next) {
+        int count = SDL_AtomicGet(&ring->full) ? TRACE_RING_SIZE : SDL_AtomicGet(&ring->head);
+        for (int i = 0; i < count; i++) {
+            if (epoch == 0 || ring->events[i].start < epoch) epoch = ring->events[i].start;
+        }
+    }
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (TraceRing* ring = allRings; ring; ring = ring->next) {
+        if (ring->threadName) {
+            fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",", ring->threadId, ring->threadName);
+            first = false;
+        }
+        int head = SDL_AtomicGet(&ring->head);
+        bool full = SDL_AtomicGet(&ring->full);
+        int count = full ? TRACE_RING_SIZE : head;
+        int oldest = full ? head : 0;
+        for (int i = 0; i < count; i++) {
+            const TraceEvent* event = &ring->events[(oldest + i) % TRACE_RING_SIZE];
+            if (!event->name || event->start < epoch) continue;
+            fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"game\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    first ? "" : ",", event->name, ring->threadId,
+                    (event->start - epoch) * usPerTick, (event->end - event->start) * usPerTick);
+            first = false;
+            written++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    SDL_Log("Wrote %d trace events to %s", written, path);
+    return true;
+}
+
+#endif
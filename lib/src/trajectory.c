@@ -0,0 +1,196 @@
+#include "trajectory.h"
+#include <math.h>
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TRAJECTORY_EPSILON 1e-4f
+#define TRAJECTORY_CORNER_EPSILON 1e-3f
+
+typedef struct {
+    Uint32 key;
+    bool valid;
+    Trajectory trajectory;
+} TrajectoryCacheEntry;
+
+struct TrajectorySolver {
+    SDL_FRect walls[TRAJECTORY_MAX_WALLS];
+    int numWalls;
+    float arenaWidth;
+    float arenaHeight;
+    float bulletSize;
+    TrajectoryCacheEntry* cache;
+};
+
+// Entry/exit-tid för en stråle mot en rektangel (slab-metoden); axis blir 0 för x-sida, 1 för y-sida, 2 för hörn
+static bool intersectRay(SDL_FPoint p, float dx, float dy, const SDL_FRect* r, float* enter, float* exit, int* axis) {
+    float tx0 = -INFINITY, tx1 = INFINITY, ty0 = -INFINITY, ty1 = INFINITY;
+    if (dx != 0.0f) {
+        tx0 = (r->x - p.x) / dx;
+        tx1 = (r->x + r->w - p.x) / dx;
+        if (tx0 > tx1) { float t = tx0; tx0 = tx1; tx1 = t; }
+    } else if (p.x <= r->x || p.x >= r->x + r->w) {
+        return false;
+    }
+    if (dy != 0.0f) {
+        ty0 = (r->y - p.y) / dy;
+        ty1 = (r->y + r->h - p.y) / dy;
+        if (ty0 > ty1) { float t = ty0; ty0 = ty1; ty1 = t; }
+    } else if (p.y <= r->y || p.y >= r->y + r->h) {
+        return false;
+    }
+    float t0 = tx0 > ty0 ? tx0 : ty0;
+    float t1 = tx1 < ty1 ? tx1 : ty1;
+    if (t0 >= t1) return false;
+    *enter = t0;
+    *exit = t1;
+    if (fabsf(tx0 - ty0) < TRAJECTORY_CORNER_EPSILON) *axis = 2;
+    else *axis = tx0 > ty0 ? 0 : 1;
+    return true;
+}
+
+static float timeToLeaveArena(const TrajectorySolver* solver, SDL_FPoint p, float dx, float dy) {
+    float t = INFINITY;
+    if (dx > 0) t = fminf(t, (solver->arenaWidth - p.x) / dx);
+    if (dx < 0) t = fminf(t, -p.x / dx);
+    if (dy > 0) t = fminf(t, (solver->arenaHeight - p.y) / dy);
+    if (dy < 0) t = fminf(t, -p.y / dy);
+    return t < 0 ? 0 : t;
+}
+
+TrajectorySolver* createTrajectorySolver(int arenaWidth, int arenaHeight, float bulletSize) {
+    TrajectorySolver* solver = calloc(1, sizeof(TrajectorySolver));
+    if (!solver) return NULL;
+    solver->cache = calloc(TRAJECTORY_CACHE_SIZE, sizeof(TrajectoryCacheEntry));
+    if (!solver->cache) {
+        free(solver);
+        return NULL;
+    }
+    solver->arenaWidth = arenaWidth;
+    solver->arenaHeight = arenaHeight;
+    solver->bulletSize = bulletSize;
+    return solver;
+}
+
+void destroyTrajectorySolver(TrajectorySolver* solver) {
+    if (!solver) return;
+    free(solver->cache);
+    free(solver);
+}
+
+bool addTrajectoryWall(TrajectorySolver* solver, const Wall* wall) {
+    if (!solver || !wall || solver->numWalls + 2 > TRAJECTORY_MAX_WALLS) return false;
+    SDL_Rect vertical, horizontal;
+    getWallRects(wall, &vertical, &horizontal);
+    const SDL_Rect* pieces[2] = { &vertical, &horizontal };
+    // Väggen växer med kulans storlek så att strålen kan följa kulans hörn i stället för hela rektangeln
+    for (int i = 0; i < 2; i++) {
+        solver->walls[solver->numWalls++] = (SDL_FRect){
+            pieces[i]->x - solver->bulletSize,
+            pieces[i]->y - solver->bulletSize,
+            pieces[i]->w + solver->bulletSize,
+            pieces[i]->h + solver->bulletSize
+        };
+    }
+    for (int i = 0; i < TRAJECTORY_CACHE_SIZE; i++) {
+        solver->cache[i].valid = false;
+    }
+    return true;
+}
+
+void traceTrajectory(const TrajectorySolver* solver, float x, float y, float angle, Trajectory* out) {
+    float radians = (angle - 90.0f) * M_PI / 180.0f;
+    float dx = cosf(radians);
+    float dy = sinf(radians);
+    SDL_FPoint p = { x, y };
+    out->numSegments = 0;
+    out->length = 0.0f;
+    out->leftArena = false;
+    while (out->numSegments < TRAJECTORY_MAX_SEGMENTS) {
+        float hitTime = INFINITY;
+        bool flipX = false, flipY = false;
+        for (int i = 0; i < solver->numWalls; i++) {
+            float enter, exit;
+            int axis;
+            if (!intersectRay(p, dx, dy, &solver->walls[i], &enter, &exit, &axis)) continue;
+            // Startar vi inne i eller precis på en vägg är det utgången som gäller, inte en ny studs
+            if (enter < TRAJECTORY_EPSILON) continue;
+            if (enter < hitTime - TRAJECTORY_CORNER_EPSILON) {
+                hitTime = enter;
+                flipX = axis != 1;
+                flipY = axis != 0;
+            } else if (enter < hitTime + TRAJECTORY_CORNER_EPSILON) {
+                flipX = flipX || axis != 1;
+                flipY = flipY || axis != 0;
+            }
+        }
+        float leaveTime = timeToLeaveArena(solver, p, dx, dy);
+        TrajectorySegment* segment = &out->segments[out->numSegments++];
+        segment->start = p;
+        if (leaveTime <= hitTime) {
+            segment->end = (SDL_FPoint){ p.x + dx * leaveTime, p.y + dy * leaveTime };
+            out->length += leaveTime;
+            out->leftArena = true;
+            return;
+        }
+        p = (SDL_FPoint){ p.x + dx * hitTime, p.y + dy * hitTime };
+        segment->end = p;
+        out->length += hitTime;
+        if (flipX) dx = -dx;
+        if (flipY) dy = -dy;
+    }
+}
+
+const Trajectory* predictTrajectory(TrajectorySolver* solver, float x, float y, float angle) {
+    int cellX = (int)floorf(x / TRAJECTORY_CELL_SIZE);
+    int cellY = (int)floorf(y / TRAJECTORY_CELL_SIZE);
+    float normalized = fmodf(angle, 360.0f);
+    if (normalized < 0) normalized += 360.0f;
+    int bucket = (int)(normalized * TRAJECTORY_ANGLE_BUCKETS / 360.0f) % TRAJECTORY_ANGLE_BUCKETS;
+    Uint32 key = ((Uint32)(cellX & 0x3FF) << 22) | ((Uint32)(cellY & 0x3FF) << 12) | (Uint32)bucket;
+    Uint32 hash = key * 2654435761u;
+    TrajectoryCacheEntry* entry = &solver->cache[(hash >> 20) % TRAJECTORY_CACHE_SIZE];
+    if (!entry->valid || entry->key != key) {
+        float cellCenterX = (cellX + 0.5f) * TRAJECTORY_CELL_SIZE;
+        float cellCenterY = (cellY + 0.5f) * TRAJECTORY_CELL_SIZE;
+        float bucketCenter = (bucket + 0.5f) * 360.0f / TRAJECTORY_ANGLE_BUCKETS;
+        traceTrajectory(solver, cellCenterX, cellCenterY, bucketCenter, &entry->trajectory);
+        entry->key = key;
+        entry->valid = true;
+    }
+    return &entry->trajectory;
+}
+
+int findTrajectoryHit(const TrajectorySolver* solver, const Trajectory* trajectory, const SDL_Rect* targets, int numTargets, SDL_FPoint* hit) {
+    for (int s = 0; s < trajectory->numSegments; s++) {
+        const TrajectorySegment* segment = &trajectory->segments[s];
+        float dx = segment->end.x - segment->start.x;
+        float dy = segment->end.y - segment->start.y;
+        float bestTime = INFINITY;
+        int best = -1;
+        for (int i = 0; i < numTargets; i++) {
+            SDL_FRect expanded = {
+                targets[i].x - solver->bulletSize,
+                targets[i].y - solver->bulletSize,
+                targets[i].w + solver->bulletSize,
+                targets[i].h + solver->bulletSize
+            };
+            float enter, exit;
+            int axis;
+            if (!intersectRay(segment->start, dx, dy, &expanded, &enter, &exit, &axis)) continue;
+            if (exit < 0.0f || enter > 1.0f) continue;
+            if (enter < 0.0f) enter = 0.0f;
+            if (enter < bestTime) {
+                bestTime = enter;
+                best = i;
+            }
+        }
+        if (best != -1) {
+            if (hit) *hit = (SDL_FPoint){ segment->start.x + dx * bestTime, segment->start.y + dy * bestTime };
+            return best;
+        }
+    }
+    return -1;
+}
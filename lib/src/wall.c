@@ -1,14 +1,16 @@
 #include "wall.h"
 
+#define MAP_WALL_INSET 100
+#define MAP_WALL_THICKNESS 20
+#define MAP_WALL_LENGTH 80
+#define SPAWN_MARGIN 10
+
 struct Wall {
     SDL_Rect vertical;
     SDL_Rect horizontal;
 };
 
-Wall* createWall(int x, int y, int thickness, int length, WallDirection dir) {
-    Wall* wall = (Wall*)malloc(sizeof(Wall));
-    if (!wall) return NULL;
-
+static void initWall(Wall* wall, int x, int y, int thickness, int length, WallDirection dir) {
     switch (dir) {
         case WALL_TOP_LEFT:
             wall->vertical = (SDL_Rect){x, y, thickness, length};
@@ -27,14 +29,100 @@ Wall* createWall(int x, int y, int thickness, int length, WallDirection dir) {
             wall->horizontal = (SDL_Rect){x, y + length - thickness, length, thickness};
             break;
     }
+}
 
+Wall* createWall(int x, int y, int thickness, int length, WallDirection dir) {
+    Wall* wall = (Wall*)malloc(sizeof(Wall));
+    if (!wall) return NULL;
+    initWall(wall, x, y, thickness, length, dir);
     return wall;
 }
 
-void renderWall(SDL_Renderer* renderer, Wall* wall) {
+Wall* createWallInArena(Arena* arena, int x, int y, int thickness, int length, WallDirection dir) {
+    Wall* wall = arenaAlloc(arena, sizeof(Wall));
+    if (!wall) return NULL;
+    initWall(wall, x, y, thickness, length, dir);
+    return wall;
+}
+
+// Samma fyra hörnväggar som servern och klienten alltid har byggt för hand
+bool createMapWalls(Arena* arena, int width, int height, Wall* walls[MAP_WALL_COUNT]) {
+    int thickness = MAP_WALL_THICKNESS;
+    int length = MAP_WALL_LENGTH;
+    int inset = MAP_WALL_INSET;
+    walls[0] = createWallInArena(arena, inset, inset, thickness, length, WALL_TOP_LEFT);
+    walls[1] = createWallInArena(arena, width - inset - length, inset, thickness, length, WALL_TOP_RIGHT);
+    walls[2] = createWallInArena(arena, inset, height - inset - length, thickness, length, WALL_BOTTOM_LEFT);
+    walls[3] = createWallInArena(arena, width - inset - length, height - inset - length, thickness, length, WALL_BOTTOM_RIGHT);
+    return walls[0] && walls[1] && walls[2] && walls[3];
+}
+
+static bool spawnHitsWall(Wall* walls[MAP_WALL_COUNT], SDL_Rect rect) {
+    for (int i = 0; i < MAP_WALL_COUNT; i++) {
+        if (wallCheckCollision(walls[i], &rect)) return true;
+    }
+    return false;
+}
+
+// nearest[c] är kvadratavståndet från rutnätspunkt c till närmaste valda punkt, -1 om den inte får användas
+static void updateNearest(float* nearest, int columns, int rows, int step, int tankSize, SDL_Point point) {
+    SDL_Rect taken = { point.x, point.y, tankSize, tankSize };
+    for (int c = 0; c < columns * rows; c++) {
+        if (nearest[c] < 0.0f) continue;
+        SDL_Rect rect = { (c % columns) * step, (c / columns) * step, tankSize, tankSize };
+        if (SDL_HasIntersection(&taken, &rect)) {
+            nearest[c] = -1.0f;
+            continue;
+        }
+        float dx = (float)(rect.x - point.x);
+        float dy = (float)(rect.y - point.y);
+        if (dx * dx + dy * dy < nearest[c]) nearest[c] = dx * dx + dy * dy;
+    }
+}
+
+int createSpawnPoints(Wall* walls[MAP_WALL_COUNT], int width, int height, int tankSize, SDL_Point* points, int maxPoints) {
+    int near = MAP_WALL_INSET + MAP_WALL_LENGTH + SPAWN_MARGIN;
+    int farX = width - near - tankSize;
+    int farY = height - near - tankSize;
+    const SDL_Point corners[4] = { {near, near}, {farX, near}, {near, farY}, {farX, farY} };
+    int count = 0;
+    for (int i = 0; i < 4 && count < maxPoints; i++) {
+        points[count++] = corners[i];
+    }
+
+    int step = tankSize + SPAWN_MARGIN;
+    int columns = (width - tankSize) / step + 1;
+    int rows = (height - tankSize) / step + 1;
+    float* nearest = malloc(sizeof(float) * columns * rows);
+    if (!nearest) return count;
+    for (int c = 0; c < columns * rows; c++) {
+        SDL_Rect rect = { (c % columns) * step, (c / columns) * step, tankSize, tankSize };
+        nearest[c] = spawnHitsWall(walls, rect) ? -1.0f : (float)width * width + (float)height * height;
+    }
+    for (int i = 0; i < count; i++) {
+        updateNearest(nearest, columns, rows, step, tankSize, points[i]);
+    }
+    // Varje ny punkt är rutnätspunkten längst från alla tidigare, så att även små rum sprids ut
+    while (count < maxPoints) {
+        int best = -1;
+        for (int c = 0; c < columns * rows; c++) {
+            if (nearest[c] >= 0.0f && (best == -1 || nearest[c] > nearest[best])) best = c;
+        }
+        if (best == -1) break;
+        points[count] = (SDL_Point){ (best % columns) * step, (best / columns) * step };
+        updateNearest(nearest, columns, rows, step, tankSize, points[count]);
+        count++;
+    }
+    free(nearest);
+    return count;
+}
+
+void renderWall(SDL_Renderer* renderer, Wall* wall, int offsetX, int offsetY) {
+    SDL_Rect vertical = { wall->vertical.x - offsetX, wall->vertical.y - offsetY, wall->vertical.w, wall->vertical.h };
+    SDL_Rect horizontal = { wall->horizontal.x - offsetX, wall->horizontal.y - offsetY, wall->horizontal.w, wall->horizontal.h };
     SDL_SetRenderDrawColor(renderer, 0, 180, 220, 255);
-    SDL_RenderFillRect(renderer, &wall->vertical);
-    SDL_RenderFillRect(renderer, &wall->horizontal);
+    SDL_RenderFillRect(renderer, &vertical);
+    SDL_RenderFillRect(renderer, &horizontal);
 }
 
 int wallCheckCollision(Wall* wall, SDL_Rect* player) {
@@ -56,6 +144,11 @@ bool wallHitsHorizontal(Wall* topLeft, Wall* topRight, Wall* bottomLeft, Wall* b
            SDL_HasIntersection(&bottomRight->horizontal, bullet);
 }
 
+void getWallRects(const Wall* wall, SDL_Rect* vertical, SDL_Rect* horizontal) {
+    *vertical = wall->vertical;
+    *horizontal = wall->horizontal;
+}
+
 void destroyWall(Wall* wall) {
     if (wall) {
         free(wall);
@@ -0,0 +1,504 @@
+#include <SDL.h>
+#include <SDL_net.h>
+#include <math.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DEFAULT_LISTEN_PORT 12345
+#define DEFAULT_SERVER_PORT 12346
+#define MAX_PROXY_CLIENTS 64
+#define PROXY_PACKET_SIZE 2048
+#define MAX_PENDING 4096
+#define MAX_PHASES 64
+#define PHASE_SETTINGS_LENGTH 256
+#define STATS_INTERVAL_MS 1000
+#define MAX_WAIT_MS 10
+#define PARETO_SHAPE 3.0
+
+typedef enum {
+    DIRECTION_UP,
+    DIRECTION_DOWN,
+    DIRECTION_COUNT
+} Direction;
+
+typedef enum {
+    DELAY_UNIFORM,
+    DELAY_NORMAL,
+    DELAY_PARETO
+} DelayDistribution;
+
+// Samma nycklar på kommandoraden och i skriptet; tider i ms, sannolikheter i procent
+typedef struct {
+    float delayMs;
+    float jitterMs;
+    DelayDistribution distribution;
+    float lossPercent;
+    float burstPercent;
+    float duplicatePercent;
+    float reorderPercent;
+    float reorderDelayMs;
+    float rateKbps;
+    float queueLimitMs;
+} Impairment;
+
+// En länk per klient och riktning, så att en klients kö inte fördröjer de andra
+typedef struct {
+    bool lastLost;
+    double linkFreeAt;
+    double lastRelease;
+} Link;
+
+typedef struct {
+    IPaddress address;
+    UDPsocket upstream;
+    Link links[DIRECTION_COUNT];
+} ProxyClient;
+
+typedef struct {
+    double releaseAt;
+    Uint32 order;
+    int client;
+    Direction direction;
+    int len;
+    Uint8 data[PROXY_PACKET_SIZE];
+} PendingPacket;
+
+typedef struct {
+    long received;
+    long forwarded;
+    long lost;
+    long queueDrops;
+    long duplicated;
+    long reordered;
+    long bytes;
+} LinkStats;
+
+typedef struct {
+    double atMs;
+    char settings[PHASE_SETTINGS_LENGTH];
+} Phase;
+
+static const char* directionNames[DIRECTION_COUNT] = { "up", "down" };
+static Impairment impairments[DIRECTION_COUNT];
+static LinkStats stats[DIRECTION_COUNT];
+static LinkStats lastStats[DIRECTION_COUNT];
+static ProxyClient clients[MAX_PROXY_CLIENTS];
+static int numClients = 0;
+static UDPsocket listenSocket;
+static UDPpacket* packet;
+static SDLNet_SocketSet socketSet;
+static IPaddress serverAddress;
+static PendingPacket pool[MAX_PENDING];
+static int freeSlots[MAX_PENDING];
+static int numFree = 0;
+static int heap[MAX_PENDING];
+static int heapSize = 0;
+static Uint32 nextOrder = 0;
+static Phase phases[MAX_PHASES];
+static int numPhases = 0;
+static int nextPhase = 0;
+static Uint64 randomState = 0x9E3779B97F4A7C15ull;
+static volatile sig_atomic_t running = 1;
+
+bool applySetting(const char* token);
+void applySettings(const char* settings);
+bool loadScript(const char* path);
+int findOrAddClient(const IPaddress* address);
+void impairPacket(int client, Direction direction, const Uint8* data, int len, double now);
+void schedulePacket(int client, Direction direction, const Uint8* data, int len, double releaseAt);
+void releaseDuePackets(double now);
+void logStats(double elapsedMs);
+double sampleDelay(const Impairment* impairment);
+double randomUnit();
+double nowMs();
+void handleSignal(int sig);
+
+int main(int argc, char* argv[]) {
+    int listenPort = DEFAULT_LISTEN_PORT;
+    const char* serverHost = "127.0.0.1";
+    int serverPort = DEFAULT_SERVER_PORT;
+    const char* scriptPath = NULL;
+    char hostBuffer[128];
+    for (int d = 0; d < DIRECTION_COUNT; d++) {
+        impairments[d].queueLimitMs = 500.0f;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--listen") == 0 && i + 1 < argc) {
+            listenPort = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+            snprintf(hostBuffer, sizeof(hostBuffer), "%s", argv[++i]);
+            char* colon = strchr(hostBuffer, ':');
+            if (colon) {
+                *colon = '\0';
+                serverPort = atoi(colon + 1);
+            }
+            serverHost = hostBuffer;
+        } else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            scriptPath = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            randomState = strtoull(argv[++i], NULL, 10) | 1;
+        } else if (!applySetting(argv[i])) {
+            SDL_Log("Unknown argument: %s", argv[i]);
+            SDL_Log("Usage: netproxy [--listen port] [--server host:port] [--script file] [--seed n] [up.|down.]key=value ...");
+            SDL_Log("Keys: delay jitter dist=uniform|normal|pareto loss burst dup reorder reorderdelay rate queue");
+            return 1;
+        }
+    }
+    if (scriptPath && !loadScript(scriptPath)) return 1;
+    if (SDL_Init(SDL_INIT_TIMER) != 0 || SDLNet_Init() == -1) {
+        SDL_Log("Init: %s", SDL_GetError());
+        return 1;
+    }
+    if (SDLNet_ResolveHost(&serverAddress, serverHost, serverPort) == -1) {
+        SDL_Log("SDLNet_ResolveHost: %s", SDLNet_GetError());
+        return 1;
+    }
+    listenSocket = SDLNet_UDP_Open(listenPort);
+    socketSet = SDLNet_AllocSocketSet(MAX_PROXY_CLIENTS + 1);
+    packet = SDLNet_AllocPacket(PROXY_PACKET_SIZE);
+    if (!listenSocket || !socketSet || !packet) {
+        SDL_Log("netproxy: %s", SDLNet_GetError());
+        return 1;
+    }
+    SDLNet_UDP_AddSocket(socketSet, listenSocket);
+    for (int i = 0; i < MAX_PENDING; i++) {
+        freeSlots[numFree++] = MAX_PENDING - 1 - i;
+    }
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+    SDL_Log("netproxy: %d -> %s:%d", listenPort, serverHost, serverPort);
+
+    double start = nowMs();
+    double nextStats = start + STATS_INTERVAL_MS;
+    while (running) {
+        double now = nowMs();
+        while (nextPhase < numPhases && now - start >= phases[nextPhase].atMs) {
+            SDL_Log("Phase at %.1f s: %s", phases[nextPhase].atMs / 1000.0, phases[nextPhase].settings);
+            applySettings(phases[nextPhase].settings);
+            nextPhase++;
+        }
+        releaseDuePackets(now);
+        if (now >= nextStats) {
+            logStats(now - start);
+            nextStats += STATS_INTERVAL_MS;
+        }
+        // Sover till nästa paket ska ut, men aldrig så länge att skriptets faser kommer för sent
+        double wait = MAX_WAIT_MS;
+        if (heapSize > 0 && pool[heap[0]].releaseAt - now < wait) wait = pool[heap[0]].releaseAt - now;
+        if (wait < 0) wait = 0;
+        if (SDLNet_CheckSockets(socketSet, (Uint32)wait) <= 0) continue;
+        now = nowMs();
+        while (SDLNet_UDP_Recv(listenSocket, packet) > 0) {
+            int client = findOrAddClient(&packet->address);
+            if (client != -1) impairPacket(client, DIRECTION_UP, packet->data, packet->len, now);
+        }
+        for (int i = 0; i < numClients; i++) {
+            while (SDLNet_UDP_Recv(clients[i].upstream, packet) > 0) {
+                impairPacket(i, DIRECTION_DOWN, packet->data, packet->len, now);
+            }
+        }
+    }
+    logStats(nowMs() - start);
+    for (int d = 0; d < DIRECTION_COUNT; d++) {
+        SDL_Log("Total %s: %ld in, %ld out, %ld lost, %ld queue drops, %ld duplicated, %ld reordered",
+                directionNames[d], stats[d].received, stats[d].forwarded, stats[d].lost,
+                stats[d].queueDrops, stats[d].duplicated, stats[d].reordered);
+    }
+    for (int i = 0; i < numClients; i++) {
+        SDLNet_UDP_Close(clients[i].upstream);
+    }
+    SDLNet_UDP_Close(listenSocket);
+    SDLNet_FreeSocketSet(socketSet);
+    SDLNet_FreePacket(packet);
+    SDLNet_Quit();
+    SDL_Quit();
+    return 0;
+}
+
+
+// "loss=5" gäller båda riktningarna, "down.loss=5" bara trafiken från servern
+bool applySetting(const char* token) {
+    const char* equals = strchr(token, '=');
+    if (!equals) return false;
+    int first = DIRECTION_UP, last = DIRECTION_DOWN;
+    const char* key = token;
+    if (strncmp(token, "up.", 3) == 0) {
+        last = DIRECTION_UP;
+        key += 3;
+    } else if (strncmp(token, "down.", 5) == 0) {
+        first = DIRECTION_DOWN;
+        key += 5;
+    }
+    int keyLength = (int)(equals - key);
+    const char* value = equals + 1;
+    float number = (float)atof(value);
+    for (int d = first; d <= last; d++) {
+        Impairment* impairment = &impairments[d];
+        if (keyLength == 5 && strncmp(key, "delay", 5) == 0) {
+            impairment->delayMs = number;
+        } else if (keyLength == 6 && strncmp(key, "jitter", 6) == 0) {
+            impairment->jitterMs = number;
+        } else if (keyLength == 4 && strncmp(key, "dist", 4) == 0) {
+            if (strcmp(value, "uniform") == 0) impairment->distribution = DELAY_UNIFORM;
+            else if (strcmp(value, "normal") == 0) impairment->distribution = DELAY_NORMAL;
+            else if (strcmp(value, "pareto") == 0) impairment->distribution = DELAY_PARETO;
+            else return false;
+        } else if (keyLength == 4 && strncmp(key, "loss", 4) == 0) {
+            impairment->lossPercent = number;
+        } else if (keyLength == 5 && strncmp(key, "burst", 5) == 0) {
+            impairment->burstPercent = number;
+        } else if (keyLength == 3 && strncmp(key, "dup", 3) == 0) {
+            impairment->duplicatePercent = number;
+        } else if (keyLength == 7 && strncmp(key, "reorder", 7) == 0) {
+            impairment->reorderPercent = number;
+        } else if (keyLength == 12 && strncmp(key, "reorderdelay", 12) == 0) {
+            impairment->reorderDelayMs = number;
+        } else if (keyLength == 4 && strncmp(key, "rate", 4) == 0) {
+            impairment->rateKbps = number;
+        } else if (keyLength == 5 && strncmp(key, "queue", 5) == 0) {
+            impairment->queueLimitMs = number;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void applySettings(const char* settings) {
+    char buffer[PHASE_SETTINGS_LENGTH];
+    snprintf(buffer, sizeof(buffer), "%s", settings);
+    for (char* token = strtok(buffer, " \t"); token; token = strtok(NULL, " \t")) {
+        if (!applySetting(token)) SDL_Log("Ignoring unknown setting: %s", token);
+    }
+}
+
+
+// En fas per rad: sekunder från start följt av inställningar, t.ex. "30 loss=10 down.delay=150".
+// Varje fas ändrar bara de nycklar den nämner; # inleder en kommentar.
+bool loadScript(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        SDL_Log("Could not open script %s", path);
+        return false;
+    }
+    char line[PHASE_SETTINGS_LENGTH + 32];
+    while (fgets(line, sizeof(line), file)) {
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+        line[strcspn(line, "\r\n")] = '\0';
+        double seconds;
+        int consumed;
+        if (sscanf(line, " %lf%n", &seconds, &consumed) != 1) continue;
+        if (numPhases == MAX_PHASES) {
+            SDL_Log("Script has more than %d phases, ignoring the rest", MAX_PHASES);
+            break;
+        }
+        Phase* phase = &phases[numPhases];
+        phase->atMs = seconds * 1000.0;
+        snprintf(phase->settings, sizeof(phase->settings), "%s", line + consumed + strspn(line + consumed, " \t"));
+        if (numPhases > 0 && phase->atMs < phases[numPhases - 1].atMs) {
+            SDL_Log("Script phases must be in time order: %s", line);
+            fclose(file);
+            return false;
+        }
+        numPhases++;
+    }
+    fclose(file);
+    SDL_Log("Loaded %d phases from %s", numPhases, path);
+    return true;
+}
+
+
+// En egen socket mot servern per klient, så att servern ser klienterna som olika adresser
+int findOrAddClient(const IPaddress* address) {
+    for (int i = 0; i < numClients; i++) {
+        if (clients[i].address.host == address->host && clients[i].address.port == address->port) {
+            return i;
+        }
+    }
+    if (numClients == MAX_PROXY_CLIENTS) return -1;
+    UDPsocket upstream = SDLNet_UDP_Open(0);
+    if (!upstream) {
+        SDL_Log("SDLNet_UDP_Open: %s", SDLNet_GetError());
+        return -1;
+    }
+    SDLNet_UDP_AddSocket(socketSet, upstream);
+    memset(&clients[numClients], 0, sizeof(ProxyClient));
+    clients[numClients].address = *address;
+    clients[numClients].upstream = upstream;
+    return numClients++;
+}
+
+
+void impairPacket(int client, Direction direction, const Uint8* data, int len, double now) {
+    const Impairment* impairment = &impairments[direction];
+    Link* link = &clients[client].links[direction];
+    LinkStats* linkStats = &stats[direction];
+    linkStats->received++;
+    // Med burst > 0 blir förlusterna korrelerade: efter ett tappat paket gäller burst i stället för loss
+    float lossChance = link->lastLost && impairment->burstPercent > 0 ? impairment->burstPercent : impairment->lossPercent;
+    link->lastLost = randomUnit() * 100.0 < lossChance;
+    if (link->lastLost) {
+        linkStats->lost++;
+        return;
+    }
+    int copies = randomUnit() * 100.0 < impairment->duplicatePercent ? 2 : 1;
+    if (copies == 2) linkStats->duplicated++;
+    for (int copy = 0; copy < copies; copy++) {
+        // Flaskhalsen först: paketet väntar tills länken är ledig och tar len * 8 / rate ms att skicka
+        double departure = now;
+        if (impairment->rateKbps > 0) {
+            if (link->linkFreeAt > departure) departure = link->linkFreeAt;
+            if (departure - now > impairment->queueLimitMs) {
+                linkStats->queueDrops++;
+                continue;
+            }
+            departure += len * 8.0 / impairment->rateKbps;
+            link->linkFreeAt = departure;
+        }
+        double releaseAt = departure + sampleDelay(impairment);
+        if (randomUnit() * 100.0 < impairment->reorderPercent) {
+            releaseAt += impairment->reorderDelayMs;
+            linkStats->reordered++;
+        } else {
+            // Jitter ensam kastar inte om paketen, det gör bara reorder
+            if (releaseAt < link->lastRelease) releaseAt = link->lastRelease;
+            link->lastRelease = releaseAt;
+        }
+        schedulePacket(client, direction, data, len, releaseAt);
+    }
+}
+
+
+static bool releasesBefore(int a, int b) {
+    if (pool[a].releaseAt != pool[b].releaseAt) return pool[a].releaseAt < pool[b].releaseAt;
+    return (Sint32)(pool[a].order - pool[b].order) < 0;
+}
+
+static void swapHeap(int a, int b) {
+    int slot = heap[a];
+    heap[a] = heap[b];
+    heap[b] = slot;
+}
+
+void schedulePacket(int client, Direction direction, const Uint8* data, int len, double releaseAt) {
+    if (numFree == 0) {
+        stats[direction].queueDrops++;
+        return;
+    }
+    int slot = freeSlots[--numFree];
+    PendingPacket* pending = &pool[slot];
+    pending->releaseAt = releaseAt;
+    pending->order = nextOrder++;
+    pending->client = client;
+    pending->direction = direction;
+    pending->len = len < PROXY_PACKET_SIZE ? len : PROXY_PACKET_SIZE;
+    memcpy(pending->data, data, pending->len);
+    int i = heapSize++;
+    heap[i] = slot;
+    while (i > 0 && releasesBefore(heap[i], heap[(i - 1) / 2])) {
+        swapHeap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+
+void releaseDuePackets(double now) {
+    while (heapSize > 0 && pool[heap[0]].releaseAt <= now) {
+        int slot = heap[0];
+        heap[0] = heap[--heapSize];
+        int i = 0;
+        while (true) {
+            int smallest = i;
+            int left = 2 * i + 1, right = 2 * i + 2;
+            if (left < heapSize && releasesBefore(heap[left], heap[smallest])) smallest = left;
+            if (right < heapSize && releasesBefore(heap[right], heap[smallest])) smallest = right;
+            if (smallest == i) break;
+            swapHeap(i, smallest);
+            i = smallest;
+        }
+        PendingPacket* pending = &pool[slot];
+        ProxyClient* client = &clients[pending->client];
+        memcpy(packet->data, pending->data, pending->len);
+        packet->len = pending->len;
+        if (pending->direction == DIRECTION_UP) {
+            packet->address = serverAddress;
+            SDLNet_UDP_Send(client->upstream, -1, packet);
+        } else {
+            packet->address = client->address;
+            SDLNet_UDP_Send(listenSocket, -1, packet);
+        }
+        stats[pending->direction].forwarded++;
+        stats[pending->direction].bytes += pending->len;
+        freeSlots[numFree++] = slot;
+    }
+}
+
+
+void logStats(double elapsedMs) {
+    for (int d = 0; d < DIRECTION_COUNT; d++) {
+        LinkStats* now = &stats[d];
+        LinkStats* last = &lastStats[d];
+        long received = now->received - last->received;
+        long dropped = (now->lost - last->lost) + (now->queueDrops - last->queueDrops);
+        SDL_Log("%6.1f s %-4s %4ld in %4ld out %6.1f kbit/s  lost %.1f%%  dup %ld  reorder %ld  queued %d",
+                elapsedMs / 1000.0, directionNames[d], received, now->forwarded - last->forwarded,
+                (now->bytes - last->bytes) * 8.0 / STATS_INTERVAL_MS,
+                received > 0 ? dropped * 100.0 / received : 0.0,
+                now->duplicated - last->duplicated, now->reordered - last->reordered, heapSize);
+        *last = *now;
+    }
+}
+
+
+// uniform: delay ± jitter, normal: jitter är standardavvikelsen, pareto: delay är golvet och jitter medel för svansen
+double sampleDelay(const Impairment* impairment) {
+    double delay = impairment->delayMs;
+    double jitter = impairment->jitterMs;
+    switch (impairment->distribution) {
+        case DELAY_UNIFORM:
+            delay += jitter * (2.0 * randomUnit() - 1.0);
+            break;
+        case DELAY_NORMAL: {
+            double u1 = randomUnit();
+            double u2 = randomUnit();
+            if (u1 < 1e-12) u1 = 1e-12;
+            delay += jitter * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+            break;
+        }
+        case DELAY_PARETO: {
+            double u = 1.0 - randomUnit();
+            delay += jitter * (PARETO_SHAPE - 1.0) * (pow(u, -1.0 / PARETO_SHAPE) - 1.0);
+            break;
+        }
+    }
+    return delay > 0 ? delay : 0;
+}
+
+
+// xorshift64*, så att samma --seed ger samma förluster och fördröjningar
+double randomUnit() {
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    return ((randomState * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+double nowMs() {
+    return SDL_GetPerformanceCounter() * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+
+void handleSignal(int sig) {
+    (void)sig;
+    running = 0;
+}
@@ -0,0 +1,133 @@
+#include <SDL.h>
+#include <SDL_net.h>
+#include <stdlib.h>
+#include <string.h>
+#include "packet_capture.h"
+
+#define SERVER_PORT 12345
+#define MAX_REPLAY_SOURCES 64
+
+// En socket per inspelad källadress, så att servern ser lika många klienter som i inspelningen
+typedef struct {
+    IPaddress captured;
+    UDPsocket socket;
+} ReplaySource;
+
+static ReplaySource sources[MAX_REPLAY_SOURCES];
+static int numSources = 0;
+
+UDPsocket socketForSource(const IPaddress* address);
+void drainReplies(UDPpacket* reply);
+void waitUntil(Uint64 deadline);
+
+int main(int argc, char* argv[]) {
+    const char* capturePath = NULL;
+    const char* host = "127.0.0.1";
+    double speed = 1.0;
+    bool maxSpeed = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max") == 0) {
+            maxSpeed = true;
+        } else if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            host = argv[++i];
+        } else if (!capturePath) {
+            capturePath = argv[i];
+        } else {
+            SDL_Log("Unknown argument: %s", argv[i]);
+        }
+    }
+    if (!capturePath || speed <= 0.0) {
+        SDL_Log("Usage: replay <capture> [--speed N | --max] [--host ip]");
+        return 1;
+    }
+    if (SDL_Init(SDL_INIT_TIMER) != 0 || SDLNet_Init() == -1) {
+        SDL_Log("Init: %s", SDL_GetError());
+        return 1;
+    }
+    IPaddress server;
+    if (SDLNet_ResolveHost(&server, host, SERVER_PORT) == -1) {
+        SDL_Log("SDLNet_ResolveHost: %s", SDLNet_GetError());
+        return 1;
+    }
+    PacketCapture* capture = openCaptureReader(capturePath);
+    UDPpacket* packet = SDLNet_AllocPacket(CAPTURE_MAX_PACKET);
+    UDPpacket* reply = SDLNet_AllocPacket(CAPTURE_MAX_PACKET);
+    static CapturedPacket record;
+    if (!capture || !packet || !reply) return 1;
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    long sent = 0;
+    long bytes = 0;
+    Uint32 lastTime = 0;
+    while (readCapturedPacket(capture, &record)) {
+        UDPsocket socket = socketForSource(&record.address);
+        if (!socket) continue;
+        if (!maxSpeed) {
+            waitUntil(start + (Uint64)(record.time / speed * frequency / 1000.0));
+        }
+        memcpy(packet->data, record.data, record.len);
+        packet->len = record.len;
+        packet->address = server;
+        SDLNet_UDP_Send(socket, -1, packet);
+        sent++;
+        bytes += record.len;
+        lastTime = record.time;
+        if ((sent & 63) == 0) drainReplies(reply);
+    }
+    double elapsed = (SDL_GetPerformanceCounter() - start) / (double)frequency;
+    SDL_Log("Replay: %ld paket, %ld bytes från %d källor på %.3f s (inspelat %.3f s), %.0f paket/s",
+            sent, bytes, numSources, elapsed, lastTime / 1000.0, elapsed > 0 ? sent / elapsed : 0.0);
+
+    closeCapture(capture);
+    for (int i = 0; i < numSources; i++) {
+        SDLNet_UDP_Close(sources[i].socket);
+    }
+    SDLNet_FreePacket(packet);
+    SDLNet_FreePacket(reply);
+    SDLNet_Quit();
+    SDL_Quit();
+    return 0;
+}
+
+
+UDPsocket socketForSource(const IPaddress* address) {
+    for (int i = 0; i < numSources; i++) {
+        if (sources[i].captured.host == address->host && sources[i].captured.port == address->port) {
+            return sources[i].socket;
+        }
+    }
+    if (numSources == MAX_REPLAY_SOURCES) return NULL;
+    UDPsocket socket = SDLNet_UDP_Open(0);
+    if (!socket) {
+        SDL_Log("SDLNet_UDP_Open: %s", SDLNet_GetError());
+        return NULL;
+    }
+    sources[numSources].captured = *address;
+    sources[numSources].socket = socket;
+    numSources++;
+    return socket;
+}
+
+
+// Svaren behövs inte, men de måste läsas så att socketbufferten inte fylls
+void drainReplies(UDPpacket* reply) {
+    for (int i = 0; i < numSources; i++) {
+        while (SDLNet_UDP_Recv(sources[i].socket, reply) > 0) {
+        }
+    }
+}
+
+
+// Sover grovt och snurrar de sista millisekunderna, samma upplägg som frame-pacern
+void waitUntil(Uint64 deadline) {
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    while (true) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (now >= deadline) return;
+        Uint64 remainingMs = (deadline - now) * 1000 / frequency;
+        if (remainingMs > 2) SDL_Delay((Uint32)(remainingMs - 1));
+    }
+}
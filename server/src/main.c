@@ -1,96 +1,336 @@
 #include <SDL.h>
 #include <SDL_net.h>
 #include <string.h>
+#include <stdio.h>
 #include "tank_server.h"
 #include "network_protocol.h"
 #include "wall.h"
 #include "collision.h"
 #include "bullet_server.h"
+#include "trace.h"
+#include "reliable_channel.h"
+#include "timer_wheel.h"
+#include "packet_capture.h"
+#include "arena.h"
+#include "snapshot_codec.h"
+#include "camera.h"
+#include "spsc_queue.h"
+#include "stats_log.h"
+#include "async_log.h"
+#include "spectator_feed.h"
 #include <math.h> 
+#include <signal.h>
+#include <time.h>
 
 #define SERVER_PORT 12345
-#define MAX_PLAYERS 4
-#define WINDOW_WIDTH 800
-#define WINDOW_HEIGHT 600
-#define MAX_BULLETS_PER_PLAYER 5
+#define DEFAULT_ROOM_SIZE 4
+#define TANK_SIZE 64
+#define VIEW_WIDTH 800
+#define VIEW_HEIGHT 600
+#define MAX_WORLD_SIZE 65535
+#define AOI_MARGIN 200
+#define PLAYER_PACKETS_PER_SECOND 120
+#define PLAYER_PACKET_BURST 60
+#define PLAYER_BYTES_PER_SECOND 8192
+#define PLAYER_BYTE_BURST 4096
+#define FIRE_COOLDOWN_SLACK_MS 100
+#define CONNECT_PACKETS_PER_SECOND 20
+#define CONNECT_PACKET_BURST 10
+#define HEARTBEAT_TIMEOUT_MS 5000
+#define JOIN_TIMEOUT_MS 2000
+#define TICK_INTERVAL_MS 100
+#define TIMER_RESOLUTION_MS 10
+// Steget som huvudloopens upplösning gav per tick; kollisionerna testar bara målrektangeln
+#define TICK_STEP_DT (TIMER_RESOLUTION_MS / 1000.0f)
+#define SERVER_PACKET_SIZE SNAPSHOT_PART_SIZE
+#define MATCH_ARENA_SIZE (64 * 1024)
+#define COUNTDOWN_MS 3000
+#define RESULTS_MS 3000
+#define MIN_ROUND_PLAYERS 2
+#define INBOUND_PACKET_SIZE 128
+#define INBOUND_QUEUE_SIZE 1024
+#define OUTBOUND_QUEUE_SIZE 1024
+#define NETWORK_WAIT_MS 1
+#define PING_REPLIES_PER_SECOND 2000
+#define PING_REPLY_BURST 200
+#define DEFAULT_STATS_FILE "match_stats.bin"
+#define MAX_SPECTATORS 512
+#define SPECTATOR_TIMEOUT_MS 5000
+#define SPECTATOR_MAX_DELAY_S 120
+#define SPECTATOR_FEED_SLACK 20
+#define SPECTATE_REPLIES_PER_SECOND 500
+#define SPECTATE_REPLY_BURST 100
+
+// Klientpaket är små; större än så släpper nätverkstråden direkt
+typedef struct {
+    IPaddress address;
+    int len;
+    Uint8 data[INBOUND_PACKET_SIZE];
+} InboundPacket;
+
+typedef struct {
+    IPaddress address;
+    int len;
+    Uint8 data[SERVER_PACKET_SIZE];
+} OutboundPacket;
+
+typedef struct {
+    IPaddress address;
+    Uint32 lastSeen;
+} Spectator;
 
-static int maxConnectedPlayers = 0;
 static Player connectedPlayers[MAX_PLAYERS];
 static PlayerStatus playerStatus[MAX_PLAYERS];
-static ServerBullet bullets[MAX_PLAYERS * MAX_BULLETS_PER_PLAYER];
+static ReliableChannel controlChannels[MAX_PLAYERS];
+static ServerBullet bullets[MAX_ROOM_BULLETS];
 int numConnectedPlayers = 0;
 static Tank* tanks[MAX_PLAYERS];
+static Tank* tankPool[MAX_PLAYERS];
+static SDL_Point spawnPoints[MAX_PLAYERS];
+static int numSpawnPoints = 0;
+static int roomSize = DEFAULT_ROOM_SIZE;
+static int worldWidth = VIEW_WIDTH;
+static int worldHeight = VIEW_HEIGHT;
+static int serverPort = SERVER_PORT;
 static UDPsocket serverSocket;
 static UDPpacket *packet;
+static TokenBucket connectBucket;
+static TimerWheel timers;
+static TimerEntry heartbeatTimers[MAX_PLAYERS];
+static TimerEntry retransmitTimers[MAX_PLAYERS];
+static TimerEntry tickTimer;
+static TimerEntry phaseTimer;
+static Arena* matchArena;
+static RoomPhase roomPhase = ROOM_LOBBY;
+static int roundNumber = 0;
+static int lastWinner = 0;
+static Uint32 phaseEndsAt = 0;
+static Uint32 simulationTime = 0;
+static Uint32 roundStartedAt = 0;
 Wall* topLeftWall;
 Wall* topRightWall;
 Wall* bottomLeftWall;
 Wall* bottomRightWall;
+static volatile sig_atomic_t running = 1;
+static volatile sig_atomic_t traceRequested = 0;
+static const char* traceFile = NULL;
+static const char* captureFile = NULL;
+static PacketCapture* capture = NULL;
+static const char* statsFile = DEFAULT_STATS_FILE;
+static StatsWriter* statsWriter = NULL;
+// Nätverkstråden äger socketen; resten av servern körs på simuleringstråden.
+// Snapshots, kontrollpaket och kvittenser går via outboundQueue, bara ping- och åskådarsvar skickas direkt från nätverkstråden.
+static SpscQueue* inboundQueue;
+static SpscQueue* outboundQueue;
+static SDL_sem* inboundReady;
+static SDL_Thread* networkThreadHandle;
+static SDL_atomic_t networkRunning;
+// Åskådarlistan ägs av nätverkstråden; simuleringen ser bara antalet
+static SpectatorFeed* spectatorFeed;
+static Uint32 spectatorDelayMs = 0;
+static Uint16 spectatorSequence = 0;
+static Uint32 spectateSecret;
+static Spectator spectators[MAX_SPECTATORS];
+static int numSpectatorSlots = 0;
+static SDL_atomic_t numSpectators;
 
 bool initServer();
-bool matchStarted = false;
 void sendInitialGameData(Player *player);
-void handleClientConnections(float dt);
-void broadcastGameState();
-void checkPlayerHeartbeats();
+void handleClientConnections();
+bool startNetworkThread();
+int networkThread(void* data);
+bool answerPing(UDPpacket* request, TokenBucket* bucket, Uint32 now);
+bool isClientPacket(const UDPpacket* request);
+bool answerSpectate(UDPpacket* request, TokenBucket* bucket, Uint32 now);
+Uint32 getSpectateCookie(const IPaddress* address);
+void keepSpectator(const IPaddress* address, Uint32 now);
+void expireSpectators(Uint32 now);
+void sendSpectatorFrames(UDPpacket* ioPacket, Uint32* next, Uint32 now);
+void queueOutbound(const OutboundPacket* out);
+void queueControlPacket(const UDPpacket* control);
+int acceptConnection(Uint32 now);
+void applyInputFrames(int index, const InputPacket* request, Uint32 now);
+void fireBullet(int index, Uint32 now);
+void handleControlMessage(int index, const Uint8* message, int len, Uint32 now);
+void joinPlayer(int index, const ClientData* request, Uint32 now);
+void sendControl(int index, const void* data, int len, Uint32 now);
+void scheduleRetransmit(int index);
+void onRetransmitTimer(TimerEntry* entry, Uint32 now);
+int findPlayerByAddress(const IPaddress* address);
+bool admitPacket(int index, int len, Uint32 now);
+int countPlayerBullets(int playerID);
+int gatherLiveTanks(TankState* liveTanks);
+int gatherActiveBullets(BulletState* activeBullets);
+void broadcastGameState(const TankState* liveTanks, int numLiveTanks, const BulletState* activeBullets, int numActiveBullets);
+void publishSpectatorSnapshot(const TankState* liveTanks, int numTanks, const BulletState* activeBullets, int numBullets);
+void fillTankState(int index, TankState* state);
+int selectBulletsFor(int index, const BulletState* all, int count, BulletState* out, int maxCount);
+void onHeartbeatTimer(TimerEntry* entry, Uint32 now);
+void disconnectPlayer(int index);
+void onSimulationTick(TimerEntry* entry, Uint32 now);
+bool buildMatch();
+void getSpawnPosition(int index, int* x, int* y);
+void resetRound(Uint32 now);
+void updateRoom(Uint32 now);
+void setRoomPhase(RoomPhase phase, int winningPlayerID, Uint32 now);
+void onPhaseTimer(TimerEntry* entry, Uint32 now);
+void startRoundStats(Uint32 now);
+void submitRoundStats(int winningPlayerID, Uint32 now);
+void sendRoomState(int index, Uint32 now);
 void updateTanks(float dt);
 void updateServerBullets(float dt);
 int countPlayersWithHealth();
-void broadcastMatchOver(int winningPlayerID);
-int serverThread(void* data);
+void handleSignal(int sig);
 
 int main(int argc, char* argv[]) {
-    Uint32 lastUpdate = SDL_GetTicks();
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            captureFile = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            statsFile = argv[++i];
+        } else if (strcmp(argv[i], "--max-players") == 0 && i + 1 < argc) {
+            roomSize = atoi(argv[++i]);
+            if (roomSize < 2) roomSize = 2;
+            if (roomSize > MAX_PLAYERS) roomSize = MAX_PLAYERS;
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            // Används när netproxy ligger på standardporten framför servern
+            serverPort = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--spectator-delay") == 0 && i + 1 < argc) {
+            int seconds = atoi(argv[++i]);
+            if (seconds < 0) seconds = 0;
+            if (seconds > SPECTATOR_MAX_DELAY_S) seconds = SPECTATOR_MAX_DELAY_S;
+            spectatorDelayMs = seconds * 1000;
+        } else if (strcmp(argv[i], "--world") == 0 && i + 1 < argc) {
+            // Positioner skickas som Uint16, så världen får vara högst 65535 pixlar åt varje håll
+            if (sscanf(argv[++i], "%dx%d", &worldWidth, &worldHeight) != 2 ||
+                worldWidth < VIEW_WIDTH || worldHeight < VIEW_HEIGHT ||
+                worldWidth > MAX_WORLD_SIZE || worldHeight > MAX_WORLD_SIZE) {
+                SDL_Log("--world vill ha BREDDxHÖJD mellan %dx%d och %dx%d", VIEW_WIDTH, VIEW_HEIGHT, MAX_WORLD_SIZE, MAX_WORLD_SIZE);
+                return -1;
+            }
+        } else {
+            SDL_Log("Unknown argument: %s", argv[i]);
+        }
+    }
+#ifndef TRACE_ENABLED
+    if (traceFile) {
+        SDL_Log("--trace ignored, server built without TRACE=1");
+        traceFile = NULL;
+    }
+#endif
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+#ifdef SIGUSR1
+    signal(SIGUSR1, handleSignal);
+#endif
+    TRACE_THREAD_NAME("server");
     if (!initServer()) {
         return -1;
     }
-    Uint32 lastBroadcast = SDL_GetTicks();
+    startAsyncLog();
+    if (captureFile) {
+        capture = openCaptureWriter(captureFile, SDL_GetTicks());
+        if (capture) SDL_Log("Skriver inkommande paket till %s", captureFile);
+    }
+    // Servern kör vidare utan statistik om filen inte går att öppna
+    statsWriter = createStatsWriter(statsFile);
+    if (statsWriter) SDL_Log("Skriver rundstatistik till %s", statsFile);
+    if (!startNetworkThread()) {
+        return -1;
+    }
     numConnectedPlayers = 0;
-    while (true) {
+    initTimerEntry(&tickTimer, onSimulationTick, NULL);
+    simulationTime = SDL_GetTicks();
+    scheduleTimer(&timers, &tickTimer, simulationTime + TICK_INTERVAL_MS);
+    while (running) {
         Uint32 now = SDL_GetTicks();
-        float dt = (now - lastUpdate) / 1000.0f;
-        if (dt > 0.05f) dt = 0.05f;
-        handleClientConnections(dt);
-        checkPlayerHeartbeats();
-        if (now - lastBroadcast > 100) {
-            updateTanks(dt);
-            updateServerBullets(dt);  
-            broadcastGameState();
-            lastBroadcast = now;
+        handleClientConnections();
+        TRACE_BEGIN(timerScope, "timers");
+        advanceTimerWheel(&timers, now);
+        TRACE_END(timerScope);
+        if (traceRequested && traceFile) {
+            traceRequested = 0;
+            TRACE_WRITE(traceFile);
         }
-        lastUpdate = now;
-        SDL_Delay(10);
+        // Vaknar direkt när nätverkstråden har köat paket, annars när timerhjulet kan ha något att göra
+        SDL_SemWaitTimeout(inboundReady, TIMER_RESOLUTION_MS);
     }
-    destroyWall(topLeftWall);
-    destroyWall(topRightWall);
-    destroyWall(bottomLeftWall);
-    destroyWall(bottomRightWall);
+    SDL_AtomicSet(&networkRunning, 0);
+    SDL_WaitThread(networkThreadHandle, NULL);
+    if (traceFile) {
+        TRACE_WRITE(traceFile);
+    }
+    destroyArena(matchArena);
+    closeCapture(capture);
+    destroyStatsWriter(statsWriter);
+    destroySpscQueue(inboundQueue);
+    destroySpscQueue(outboundQueue);
+    destroySpectatorFeed(spectatorFeed);
+    SDL_DestroySemaphore(inboundReady);
+    SDLNet_FreePacket(packet);
+    SDLNet_UDP_Close(serverSocket);
+    stopAsyncLog();
+    SDLNet_Quit();
+    SDL_Log("Server stopped");
 
     return 0;
 }
 
 
+void handleSignal(int sig) {
+#ifdef SIGUSR1
+    if (sig == SIGUSR1) {
+        traceRequested = 1;
+        return;
+    }
+#endif
+    running = 0;
+}
+
+
 bool initServer() {
     if (SDLNet_Init() == -1) {
         SDL_Log("SDLNet_Init: %s", SDLNet_GetError());
         return false;
     }
-    serverSocket = SDLNet_UDP_Open(SERVER_PORT);
+    serverSocket = SDLNet_UDP_Open(serverPort);
     if (!serverSocket) {
         SDL_Log("SDLNet_UDP_Open: %s", SDLNet_GetError());
         return false;
     }
-    packet = SDLNet_AllocPacket(512);
+    packet = SDLNet_AllocPacket(SERVER_PACKET_SIZE);
     if (!packet) {
         SDL_Log("SDLNet_AllocPacket: %s", SDLNet_GetError());
         return false;
     }
-    int thickness = 20;
-    int length = 80;
-    topLeftWall = createWall(100, 100, thickness, length, WALL_TOP_LEFT);
-    topRightWall = createWall(WINDOW_WIDTH - 100 - length, 100, thickness, length, WALL_TOP_RIGHT);
-    bottomLeftWall = createWall(100, WINDOW_HEIGHT - 100 - length, thickness, length, WALL_BOTTOM_LEFT);
-    bottomRightWall = createWall(WINDOW_WIDTH - 100 - length, WINDOW_HEIGHT - 100 - length, thickness, length, WALL_BOTTOM_RIGHT);
+    initTokenBucket(&connectBucket, CONNECT_PACKET_BURST, CONNECT_PACKETS_PER_SECOND, SDL_GetTicks());
+    initTimerWheel(&timers, SDL_GetTicks(), TIMER_RESOLUTION_MS);
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        initTimerEntry(&heartbeatTimers[i], onHeartbeatTimer, NULL);
+        initTimerEntry(&retransmitTimers[i], onRetransmitTimer, NULL);
+    }
+    matchArena = createArena(MATCH_ARENA_SIZE);
+    if (!matchArena || !buildMatch()) {
+        SDL_Log("Kunde inte skapa matchens arena");
+        return false;
+    }
+    initTimerEntry(&phaseTimer, onPhaseTimer, NULL);
+    inboundQueue = createSpscQueue(INBOUND_QUEUE_SIZE, sizeof(InboundPacket));
+    outboundQueue = createSpscQueue(OUTBOUND_QUEUE_SIZE, sizeof(OutboundPacket));
+    inboundReady = SDL_CreateSemaphore(0);
+    if (!inboundQueue || !outboundQueue || !inboundReady) {
+        SDL_Log("Kunde inte skapa köerna mellan trådarna");
+        return false;
+    }
+    // Ringen rymmer fördröjningen plus marginal för att nätverkstråden ska hinna läsa innan platsen återanvänds
+    spectatorFeed = createSpectatorFeed(spectatorDelayMs / TICK_INTERVAL_MS + SPECTATOR_FEED_SLACK);
+    if (!spectatorFeed) {
+        SDL_Log("Kunde inte skapa åskådarringen");
+        return false;
+    }
+    spectateSecret = (Uint32)SDL_GetPerformanceCounter() ^ (Uint32)time(NULL);
     SDL_Log("Server started");
 
     return true;
@@ -98,141 +338,460 @@ bool initServer() {
 
 
 void sendInitialGameData(Player *player) {
-    UDPpacket *initPacket = SDLNet_AllocPacket(512);
-    if (!initPacket) {
-        SDL_Log("ERROR: Kunde inte allokera nytt paket för GameInitData");
-        return;
-    }
+    int index = player->playerID - 1;
     GameInitData initData = {
         .command = START_MATCH,
         .playerID = player->playerID,
-        .arenaWidth = WINDOW_WIDTH,
-        .arenaHeight = WINDOW_HEIGHT
+        .arenaWidth = worldWidth,
+        .arenaHeight = worldHeight
     };
-    initPacket->address = player->address;
-    memcpy(initPacket->data, &initData, sizeof(GameInitData));
-    initPacket->len = sizeof(GameInitData);
-    SDLNet_UDP_Send(serverSocket, -1, initPacket);
-    SDLNet_FreePacket(initPacket);
+    sendControl(index, &initData, sizeof(GameInitData), SDL_GetTicks());
 }
 
 
-void handleClientConnections(float dt) {
-    while (SDLNet_UDP_Recv(serverSocket, packet)) {
-        ClientData request;
-        memcpy(&request, packet->data, sizeof(ClientData));
-        if (request.command == CONNECT && numConnectedPlayers < MAX_PLAYERS) {
-            int index = -1;
-            for (int i = 0; i < MAX_PLAYERS; i++) {
-                if (!connectedPlayers[i].active) {
-                    index = i;
-                    break;
-                }
-            }
-            if (index == -1) {
-                SDL_Log("Server full – kunde inte tilldela plats.");
-                continue;
-            }
-            Player newPlayer = {
-                .address = packet->address,
-                .playerID = index + 1,
-                .active = true
-            };
-            connectedPlayers[index] = newPlayer;
-            Tank* tank = createTank();
-            if (!tank) {
-                SDL_Log("ERROR: Kunde inte skapa tank för spelare %d", index + 1);
-                continue;
-            }
-            int margin = 10;
-            int tankW = 64, tankH = 64;
-            int length = 80;
-            int x = 0, y = 0;
-            switch (index) {
-                case 0: x = 100 + length + margin; y = 100 + length + margin; break;
-                case 1: x = WINDOW_WIDTH - 100 - length - tankW - margin; y = 100 + length + margin; break;
-                case 2: x = 100 + length + margin; y = WINDOW_HEIGHT - 100 - length - tankH - margin; break;
-                case 3: x = WINDOW_WIDTH - 100 - length - tankW - margin; y = WINDOW_HEIGHT - 100 - length - tankH - margin; break;
-                default: x = 400; y = 300; break;
-            }
-            setTankPosition(tank, x, y);
-            setTankColorId(tank, request.tankColorId);
-            setTankHealth(tank, 3);
-            tanks[index] = tank;
-            playerStatus[index].lastHeartbeat = SDL_GetTicks();
-            playerStatus[index].active = true;
-            numConnectedPlayers++;
-            if (numConnectedPlayers > maxConnectedPlayers) {
-                maxConnectedPlayers = numConnectedPlayers;
+// Paketen kopieras till packet så att kontrollkanalen kan svara i samma buffert som förut
+void handleClientConnections() {
+    TRACE_SCOPE("handleClientConnections");
+    InboundPacket in;
+    while (popSpscQueue(inboundQueue, &in)) {
+        Uint32 now = SDL_GetTicks();
+        memcpy(packet->data, in.data, in.len);
+        packet->len = in.len;
+        packet->address = in.address;
+        int sender = findPlayerByAddress(&packet->address);
+        if (!admitPacket(sender, packet->len, now)) continue;
+        if (isControlPacket(packet)) {
+            if (sender == -1) sender = acceptConnection(now);
+            if (sender == -1) continue;
+            handleReliablePacket(&controlChannels[sender], NULL, packet, now);
+            Uint8 message[MAX_CONTROL_PAYLOAD];
+            int len;
+            while ((len = receiveReliable(&controlChannels[sender], message, sizeof(message))) > 0) {
+                handleControlMessage(sender, message, len, now);
             }
-            SDL_Log("New player connected. ID: %d, total players: %d", newPlayer.playerID, numConnectedPlayers);
-            ClientData response = { CONNECT };
-            response.playerNumber = newPlayer.playerID;
-            memcpy(packet->data, &response, sizeof(ClientData));
-            packet->len = sizeof(ClientData);
-            packet->address = newPlayer.address;
-            SDLNet_UDP_Send(serverSocket, -1, packet);
-            if (!matchStarted && numConnectedPlayers >= 1) {
-                matchStarted = true;
+            continue;
+        }
+        if (sender == -1 || !tanks[sender] || packet->len < (int)sizeof(ClientCommand)) continue;
+        ClientCommand command;
+        memcpy(&command, packet->data, sizeof(ClientCommand));
+        if (command == UPDATE && packet->len >= (int)sizeof(InputPacket)) {
+            InputPacket request;
+            memcpy(&request, packet->data, sizeof(InputPacket));
+            if (request.playerNumber != connectedPlayers[sender].playerID) continue;
+            playerStatus[sender].lastHeartbeat = now;
+            handleSnapshotAck(&playerStatus[sender].snapshots, request.snapshotAck, request.snapshotAckBits, now);
+            applyInputFrames(sender, &request, now);
+        }
+    }
+}
+
+
+bool startNetworkThread() {
+    SDL_AtomicSet(&networkRunning, 1);
+    networkThreadHandle = SDL_CreateThread(networkThread, "network", NULL);
+    if (!networkThreadHandle) {
+        SDL_Log("SDL_CreateThread: %s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+
+// Rör aldrig spelets tillstånd: tar emot, sållar och köar paket, och skickar det simuleringen har kodat
+int networkThread(void* data) {
+    TRACE_THREAD_NAME("network");
+    UDPpacket* ioPacket = SDLNet_AllocPacket(SERVER_PACKET_SIZE);
+    SDLNet_SocketSet socketSet = SDLNet_AllocSocketSet(1);
+    if (!ioPacket || !socketSet) {
+        SDL_Log("networkThread: %s", SDLNet_GetError());
+        return -1;
+    }
+    SDLNet_UDP_AddSocket(socketSet, serverSocket);
+    TokenBucket pingBucket;
+    initTokenBucket(&pingBucket, PING_REPLY_BURST, PING_REPLIES_PER_SECOND, SDL_GetTicks());
+    TokenBucket spectateBucket;
+    initTokenBucket(&spectateBucket, SPECTATE_REPLY_BURST, SPECTATE_REPLIES_PER_SECOND, SDL_GetTicks());
+    Uint32 nextSpectatorFrame = getSpectatorFeedHead(spectatorFeed);
+    bool overflowing = false;
+    OutboundPacket out;
+    while (SDL_AtomicGet(&networkRunning)) {
+        SDLNet_CheckSockets(socketSet, NETWORK_WAIT_MS);
+        bool queued = false;
+        while (SDLNet_UDP_Recv(serverSocket, ioPacket) > 0) {
+            Uint32 now = SDL_GetTicks();
+            if (capture) writeCapturedPacket(capture, ioPacket, now);
+            if (answerPing(ioPacket, &pingBucket, now) || answerSpectate(ioPacket, &spectateBucket, now) ||
+                !isClientPacket(ioPacket)) continue;
+            InboundPacket in = { ioPacket->address, ioPacket->len };
+            memcpy(in.data, ioPacket->data, ioPacket->len);
+            bool pushed = pushSpscQueue(inboundQueue, &in);
+            if (!pushed && !overflowing) {
+                LOG_ASYNC("Simuleringen hinner inte med, inkommande paket släpps");
             }
-            sendInitialGameData(&connectedPlayers[index]);
-            broadcastGameState();
+            overflowing = !pushed;
+            queued |= pushed;
         }
-        else if (request.command == UPDATE) {
-            int id = request.playerNumber;
-            if (id >= 1 && id <= MAX_PLAYERS) {
-                int i = id - 1;
-                playerStatus[i].up = request.up;
-                playerStatus[i].down = request.down;
-                playerStatus[i].left = request.left;
-                playerStatus[i].right = request.right;
-                playerStatus[i].angle = request.angle;
-                playerStatus[i].lastHeartbeat = SDL_GetTicks();
-                if (request.shooting && tanks[i]) {
-                    for (int j = 0; j < MAX_PLAYERS * MAX_BULLETS_PER_PLAYER; j++) {
-                        if (!bullets[j].active) {
-                            initServerBullet(&bullets[j]);
-                            SDL_Rect rect = getTankRect(tanks[i]);
-                            float angle = playerStatus[i].angle;
-                            float radians = (angle - 90.0f) * M_PI / 180.0f;
-                            float centerX = rect.x + rect.w / 2;
-                            float centerY = rect.y + rect.h / 2;
-                            float muzzleOffset = rect.h / 2 + 10;
-                            float startX = centerX + cosf(radians) * muzzleOffset;
-                            float startY = centerY + sinf(radians) * muzzleOffset;
-                            fireServerBullet(&bullets[j], startX, startY, angle, id);
-                            break;
-                        }
-                    }
-                }
+        if (queued) SDL_SemPost(inboundReady);
+        while (popSpscQueue(outboundQueue, &out)) {
+            memcpy(ioPacket->data, out.data, out.len);
+            ioPacket->len = out.len;
+            ioPacket->address = out.address;
+            SDLNet_UDP_Send(serverSocket, -1, ioPacket);
+        }
+        sendSpectatorFrames(ioPacket, &nextSpectatorFrame, SDL_GetTicks());
+    }
+    SDLNet_FreeSocketSet(socketSet);
+    SDLNet_FreePacket(ioPacket);
+    return 0;
+}
+
+
+// Besvaras här i stället för på simuleringstråden så att tickens väntan inte hamnar i klockskattningen.
+// Svaret är inte större än frågan, och hinken tar hand om översvämning.
+bool answerPing(UDPpacket* request, TokenBucket* bucket, Uint32 now) {
+    ClientCommand command;
+    if (request->len < (int)sizeof(PingData)) return false;
+    memcpy(&command, request->data, sizeof(ClientCommand));
+    if (command != PING) return false;
+    if (!takeTokens(bucket, 1.0f, now)) return true;
+    PingData ping;
+    memcpy(&ping, request->data, sizeof(PingData));
+    PongData pong = { PONG, ping.clientTime, SDL_GetTicks() };
+    memcpy(request->data, &pong, sizeof(PongData));
+    request->len = sizeof(PongData);
+    SDLNet_UDP_Send(serverSocket, -1, request);
+    return true;
+}
+
+
+bool isClientPacket(const UDPpacket* request) {
+    if (request->len > INBOUND_PACKET_SIZE) return false;
+    if (isControlPacket(request)) return true;
+    ClientCommand command;
+    if (request->len < (int)sizeof(InputPacket)) return false;
+    memcpy(&command, request->data, sizeof(ClientCommand));
+    return command == UPDATE;
+}
+
+
+// Svarar alltid med cookien; bara den som skickar tillbaka rätt cookie läggs till eller hålls kvar
+bool answerSpectate(UDPpacket* request, TokenBucket* bucket, Uint32 now) {
+    ClientCommand command;
+    if (request->len < (int)sizeof(SpectateRequest)) return false;
+    memcpy(&command, request->data, sizeof(ClientCommand));
+    if (command != SPECTATE) return false;
+    if (!takeTokens(bucket, 1.0f, now)) return true;
+    SpectateRequest spectate;
+    memcpy(&spectate, request->data, sizeof(SpectateRequest));
+    Uint32 cookie = getSpectateCookie(&request->address);
+    if (spectate.cookie == cookie) keepSpectator(&request->address, now);
+    SpectateInfo info = { SPECTATE_INFO, cookie, worldWidth, worldHeight, spectatorDelayMs / 1000 };
+    memcpy(request->data, &info, sizeof(SpectateInfo));
+    request->len = sizeof(SpectateInfo);
+    SDLNet_UDP_Send(serverSocket, -1, request);
+    return true;
+}
+
+
+// Beror bara på adressen och en hemlighet från starten, så servern behöver inte spara något per fråga
+Uint32 getSpectateCookie(const IPaddress* address) {
+    Uint32 x = address->host ^ spectateSecret;
+    for (int round = 0; round < 2; round++) {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+        if (round == 0) x ^= address->port;
+    }
+    // 0 betyder att klienten inte fått någon cookie än
+    return x ? x : 1;
+}
+
+
+void keepSpectator(const IPaddress* address, Uint32 now) {
+    for (int i = 0; i < numSpectatorSlots; i++) {
+        if (spectators[i].address.host == address->host && spectators[i].address.port == address->port) {
+            spectators[i].lastSeen = now;
+            return;
+        }
+    }
+    if (numSpectatorSlots == MAX_SPECTATORS) return;
+    spectators[numSpectatorSlots++] = (Spectator){ *address, now };
+    SDL_AtomicSet(&numSpectators, numSpectatorSlots);
+    LOG_ASYNC("Spectator joined, total spectators: %d", numSpectatorSlots);
+}
+
+
+void expireSpectators(Uint32 now) {
+    for (int i = 0; i < numSpectatorSlots; ) {
+        if (now - spectators[i].lastSeen < SPECTATOR_TIMEOUT_MS) {
+            i++;
+            continue;
+        }
+        spectators[i] = spectators[--numSpectatorSlots];
+        SDL_AtomicSet(&numSpectators, numSpectatorSlots);
+        LOG_ASYNC("Spectator timed out, total spectators: %d", numSpectatorSlots);
+    }
+}
+
+
+// Varje del kopieras en gång till ioPacket och skickas sedan till alla åskådare; bara adressen byts mellan sändningarna
+void sendSpectatorFrames(UDPpacket* ioPacket, Uint32* next, Uint32 now) {
+    Uint32 head = getSpectatorFeedHead(spectatorFeed);
+    // Den som halkat efter hoppar fram, men håller sig så långt från skrivaren att platsen inte återanvänds under sändningen
+    Uint32 window = getSpectatorFeedCapacity(spectatorFeed) - SPECTATOR_FEED_SLACK / 2;
+    if (head - *next > window) *next = head - window;
+    while (*next != head) {
+        Uint32 publishedAt;
+        int numParts;
+        if (!peekSpectatorFrame(spectatorFeed, *next, &publishedAt, &numParts)) {
+            (*next)++;
+            continue;
+        }
+        if (now - publishedAt < spectatorDelayMs) break;
+        expireSpectators(now);
+        for (int part = 0; part < numParts && numSpectatorSlots > 0; part++) {
+            if (!copySpectatorPart(spectatorFeed, *next, part, ioPacket->data, &ioPacket->len)) break;
+            for (int i = 0; i < numSpectatorSlots; i++) {
+                ioPacket->address = spectators[i].address;
+                SDLNet_UDP_Send(serverSocket, -1, ioPacket);
             }
         }
+        (*next)++;
+    }
+}
+
+
+void queueOutbound(const OutboundPacket* out) {
+    static bool overflowing = false;
+    bool pushed = pushSpscQueue(outboundQueue, out);
+    if (!pushed && !overflowing) {
+        LOG_ASYNC("Nätverkstråden hinner inte med, utgående paket släpps");
+    }
+    overflowing = !pushed;
+}
+
+
+// Kontrollkanalens paket och kvittenser går samma väg som snapshots; ett tappat paket skickas om av kanalen
+void queueControlPacket(const UDPpacket* control) {
+    OutboundPacket out = { control->address, control->len };
+    memcpy(out.data, control->data, control->len);
+    queueOutbound(&out);
+}
+
+
+// Ramarna kommer nyaste först; de som redan tillämpats hoppas över, resten spelas upp äldst först
+void applyInputFrames(int index, const InputPacket* request, Uint32 now) {
+    PlayerStatus* status = &playerStatus[index];
+    int numFrames = request->numFrames < INPUT_HISTORY ? request->numFrames : INPUT_HISTORY;
+    for (int f = numFrames - 1; f >= 0; f--) {
+        const InputFrame* frame = &request->frames[f];
+        if (status->hasInput && (Sint16)(frame->sequence - status->lastInputSequence) <= 0) continue;
+        status->lastInputSequence = frame->sequence;
+        status->hasInput = true;
+        status->up = frame->buttons & INPUT_UP;
+        status->down = frame->buttons & INPUT_DOWN;
+        status->left = frame->buttons & INPUT_LEFT;
+        status->right = frame->buttons & INPUT_RIGHT;
+        status->angle = frame->angle;
+        if (frame->buttons & INPUT_FIRE) fireBullet(index, now);
+    }
+}
+
+
+void fireBullet(int index, Uint32 now) {
+    int id = connectedPlayers[index].playerID;
+    if (roomPhase != ROOM_PLAYING || getTankHealth(tanks[index]) <= 0 ||
+        now - playerStatus[index].lastShotTime < FIRE_COOLDOWN_MS - FIRE_COOLDOWN_SLACK_MS ||
+        countPlayerBullets(id) >= MAX_BULLETS_PER_PLAYER) {
+        return;
+    }
+    playerStatus[index].lastShotTime = now;
+    for (int j = 0; j < MAX_ROOM_BULLETS; j++) {
+        if (!bullets[j].active) {
+            initServerBullet(&bullets[j]);
+            SDL_Rect rect = getTankRect(tanks[index]);
+            float angle = playerStatus[index].angle;
+            float radians = (angle - 90.0f) * M_PI / 180.0f;
+            float centerX = rect.x + rect.w / 2;
+            float centerY = rect.y + rect.h / 2;
+            float muzzleOffset = rect.h / 2 + 10;
+            float startX = centerX + cosf(radians) * muzzleOffset;
+            float startY = centerY + sinf(radians) * muzzleOffset;
+            fireServerBullet(&bullets[j], startX, startY, angle, id);
+            playerStatus[index].shots++;
+            break;
+        }
+    }
+}
+
+
+// Reserverar en plats när första kontrollpaketet (sekvens 0) från en ny adress är en CONNECT
+int acceptConnection(Uint32 now) {
+    ControlHeader header;
+    ClientData request;
+    // Exakt längd, annars reserveras en plats som handleControlMessage aldrig fyller
+    if (packet->len != (int)(sizeof(ControlHeader) + sizeof(ClientData))) return -1;
+    memcpy(&header, packet->data, sizeof(ControlHeader));
+    memcpy(&request, packet->data + sizeof(ControlHeader), sizeof(ClientData));
+    if (header.command != CONTROL_DATA || header.sequence != 0 || request.command != CONNECT) return -1;
+    if (numConnectedPlayers >= roomSize) return -1;
+    int index = -1;
+    for (int i = 0; i < roomSize; i++) {
+        if (!connectedPlayers[i].active) {
+            index = i;
+            break;
+        }
+    }
+    if (index == -1) {
+        LOG_ASYNC("Server full – kunde inte tilldela plats.");
+        return -1;
+    }
+    tanks[index] = NULL;
+    connectedPlayers[index] = (Player){
+        .address = packet->address,
+        .playerID = index + 1,
+        .active = true
+    };
+    initReliableChannel(&controlChannels[index], packet->address);
+    controlChannels[index].send = queueControlPacket;
+    cancelTimer(&retransmitTimers[index]);
+    // Släpps av heartbeat-timern om joinPlayer aldrig hinner köra
+    playerStatus[index].active = false;
+    scheduleTimer(&timers, &heartbeatTimers[index], now + JOIN_TIMEOUT_MS);
+    return index;
+}
+
+
+void handleControlMessage(int index, const Uint8* message, int len, Uint32 now) {
+    if (len == sizeof(ClientData)) {
+        ClientData request;
+        memcpy(&request, message, sizeof(ClientData));
+        if (request.command == CONNECT && !tanks[index]) {
+            joinPlayer(index, &request, now);
+        }
+    }
+}
+
+
+// Platsens tank skapas en gång och återanvänds av alla som senare får samma plats
+void joinPlayer(int index, const ClientData* request, Uint32 now) {
+    if (!tankPool[index]) tankPool[index] = createTankInArena(matchArena);
+    Tank* tank = tankPool[index];
+    if (!tank) {
+        SDL_Log("ERROR: Kunde inte skapa tank för spelare %d", index + 1);
+        connectedPlayers[index].active = false;
+        return;
+    }
+    int x, y;
+    getSpawnPosition(index, &x, &y);
+    setTankPosition(tank, x, y);
+    setTankAngle(tank, 0);
+    setTankColorId(tank, request->tankColorId);
+    // Den som ansluter mitt i en runda får vänta på nästa
+    setTankHealth(tank, roomPhase == ROOM_PLAYING ? 0 : 3);
+    tanks[index] = tank;
+    playerStatus[index].angle = 0;
+    playerStatus[index].up = playerStatus[index].down = false;
+    playerStatus[index].left = playerStatus[index].right = false;
+    playerStatus[index].hasInput = false;
+    playerStatus[index].inRound = false;
+    playerStatus[index].lastHeartbeat = now;
+    playerStatus[index].active = true;
+    scheduleTimer(&timers, &heartbeatTimers[index], now + HEARTBEAT_TIMEOUT_MS);
+    playerStatus[index].lastShotTime = now - FIRE_COOLDOWN_MS;
+    playerStatus[index].throttled = false;
+    initTokenBucket(&playerStatus[index].packetBucket, PLAYER_PACKET_BURST, PLAYER_PACKETS_PER_SECOND, now);
+    initTokenBucket(&playerStatus[index].byteBucket, PLAYER_BYTE_BURST, PLAYER_BYTES_PER_SECOND, now);
+    initSnapshotControl(&playerStatus[index].snapshots, now);
+    numConnectedPlayers++;
+    LOG_ASYNC("New player connected. ID: %d, total players: %d", connectedPlayers[index].playerID, numConnectedPlayers);
+    ClientData response = { CONNECT };
+    response.playerNumber = connectedPlayers[index].playerID;
+    sendControl(index, &response, sizeof(ClientData), now);
+    sendInitialGameData(&connectedPlayers[index]);
+    sendRoomState(index, now);
+}
+
+
+void sendControl(int index, const void* data, int len, Uint32 now) {
+    sendReliable(&controlChannels[index], NULL, packet, data, len, now);
+    scheduleRetransmit(index);
+}
+
+
+void scheduleRetransmit(int index) {
+    Uint32 deadline;
+    if (getNextRetransmit(&controlChannels[index], &deadline)) {
+        scheduleTimer(&timers, &retransmitTimers[index], deadline);
+    } else {
+        cancelTimer(&retransmitTimers[index]);
+    }
+}
+
+
+void onRetransmitTimer(TimerEntry* entry, Uint32 now) {
+    int index = (int)(entry - retransmitTimers);
+    if (!connectedPlayers[index].active) return;
+    updateReliableChannel(&controlChannels[index], NULL, packet, now);
+    scheduleRetransmit(index);
+}
+
+
+int findPlayerByAddress(const IPaddress* address) {
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        if (connectedPlayers[i].active &&
+            connectedPlayers[i].address.host == address->host &&
+            connectedPlayers[i].address.port == address->port) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+// Körs före all avkodning så att en översvämmande klient bara kostar en adressjämförelse
+bool admitPacket(int index, int len, Uint32 now) {
+    if (index == -1) {
+        return takeTokens(&connectBucket, 1.0f, now);
+    }
+    PlayerStatus* status = &playerStatus[index];
+    bool allowed = takeTokens(&status->packetBucket, 1.0f, now) &&
+                   takeTokens(&status->byteBucket, (float)len, now);
+    if (!allowed && !status->throttled) {
+        LOG_ASYNC("Player %d exceeded its rate limit, dropping packets", connectedPlayers[index].playerID);
     }
+    status->throttled = !allowed;
+    return allowed;
 }
 
 
-void broadcastGameState() {
-    ServerData gameState;
-    gameState.command = GAME_STATE;
-    int activeTankCount = 0;
-    for (int i = 0; i < numConnectedPlayers; i++) {
-        if (tanks[i] && connectedPlayers[i].active) {
-            gameState.tanks[activeTankCount].playerNumber = connectedPlayers[i].playerID;
-            SDL_Rect rect = getTankRect(tanks[i]);
-            gameState.tanks[activeTankCount].x = rect.x;
-            gameState.tanks[activeTankCount].y = rect.y;
-            gameState.tanks[activeTankCount].angle = getTankAngle(tanks[i]);
-            gameState.tanks[activeTankCount].shooting = false;
-            gameState.tanks[activeTankCount].tankColorId = getTankColorId(tanks[i]);
-            gameState.tanks[activeTankCount].health = getTankHealth(tanks[i]);
-            activeTankCount++;
+int countPlayerBullets(int playerID) {
+    int count = 0;
+    for (int i = 0; i < MAX_ROOM_BULLETS; i++) {
+        if (bullets[i].active && bullets[i].ownerId == playerID) count++;
+    }
+    return count;
+}
+
+
+int gatherLiveTanks(TankState* liveTanks) {
+    int numLiveTanks = 0;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        if (tanks[i] && connectedPlayers[i].active && getTankHealth(tanks[i]) > 0) {
+            fillTankState(i, &liveTanks[numLiveTanks++]);
         }
     }
-    gameState.numPlayers = activeTankCount;
-    gameState.numBullets = 0;
-    for (int i = 0; i < MAX_PLAYERS * MAX_BULLETS_PER_PLAYER; i++) {
+    return numLiveTanks;
+}
+
+
+int gatherActiveBullets(BulletState* activeBullets) {
+    int numActiveBullets = 0;
+    for (int i = 0; i < MAX_ROOM_BULLETS; i++) {
         if (bullets[i].active) {
-            gameState.bullets[gameState.numBullets++] = (BulletState){
+            activeBullets[numActiveBullets++] = (BulletState){
                 .x = bullets[i].x,
                 .y = bullets[i].y,
                 .vx = bullets[i].velocityX,
@@ -242,40 +801,175 @@ void broadcastGameState() {
             };
         }
     }
-    int alivePlayers = countPlayersWithHealth();
-    for (int i = 0; i < numConnectedPlayers; i++) {
-        if (!connectedPlayers[i].active) continue;
-        packet->address = connectedPlayers[i].address;
-        memcpy(packet->data, &gameState, sizeof(ServerData));
-        packet->len = sizeof(ServerData);
-        SDLNet_UDP_Send(serverSocket, -1, packet);
-    }
+    return numActiveBullets;
 }
 
 
-void checkPlayerHeartbeats() {
-    Uint32 currentTime = SDL_GetTicks();
+void broadcastGameState(const TankState* liveTanks, int numLiveTanks, const BulletState* activeBullets, int numActiveBullets) {
+    TRACE_SCOPE("broadcastGameState");
+    Uint32 now = SDL_GetTicks();
+    TankState visibleTanks[MAX_PLAYERS];
+    BulletState visibleBullets[MAX_ROOM_BULLETS];
+    BulletState selected[MAX_ROOM_BULLETS];
+    OutboundPacket out;
     for (int i = 0; i < MAX_PLAYERS; i++) {
-        if (playerStatus[i].active && (currentTime - playerStatus[i].lastHeartbeat > 5000)) {
-            playerStatus[i].active = false;
-            connectedPlayers[i].active = false;
-            destroyTankInstance(tanks[i]);
-            tanks[i] = NULL;
-            numConnectedPlayers--;
-            SDL_Log("Player %d disconnected due to timeout. Total players: %d", connectedPlayers[i].playerID, numConnectedPlayers);
+        if (!connectedPlayers[i].active || !tanks[i]) continue;
+        SnapshotControl* snapshots = &playerStatus[i].snapshots;
+        if (!isSnapshotDue(snapshots, now)) continue;
+        // Intresseområdet är klientens kameravy plus en marginal, så att det som är på väg in redan finns
+        Camera view;
+        SDL_Rect rect = getTankRect(tanks[i]);
+        initCamera(&view, VIEW_WIDTH, VIEW_HEIGHT, worldWidth, worldHeight);
+        followCamera(&view, rect.x + rect.w / 2.0f, rect.y + rect.h / 2.0f);
+        int numTanks = 0;
+        fillTankState(i, &visibleTanks[numTanks++]);
+        for (int t = 0; t < numLiveTanks; t++) {
+            SDL_FRect bounds = { liveTanks[t].x, liveTanks[t].y, TANK_SIZE, TANK_SIZE };
+            if (liveTanks[t].playerNumber == connectedPlayers[i].playerID || !isOnCamera(&view, &bounds, AOI_MARGIN)) continue;
+            visibleTanks[numTanks++] = liveTanks[t];
+        }
+        int numVisibleBullets = 0;
+        for (int b = 0; b < numActiveBullets; b++) {
+            SDL_FRect bounds = { activeBullets[b].x, activeBullets[b].y, 15, 15 };
+            if (isOnCamera(&view, &bounds, AOI_MARGIN)) visibleBullets[numVisibleBullets++] = activeBullets[b];
+        }
+        // Tankarna skickas alltid; det är kulorna som kortas när budgeten inte räcker
+        int allowance = getSnapshotAllowance(snapshots, now);
+        if (allowance < getSnapshotSize(numTanks, 0)) continue;
+        int maxBullets = (allowance - getSnapshotSize(numTanks, 0)) / (int)sizeof(PackedBullet);
+        while (maxBullets > 0 && getSnapshotSize(numTanks, maxBullets) > allowance) maxBullets--;
+        int numBullets = selectBulletsFor(i, visibleBullets, numVisibleBullets, selected, maxBullets);
+        int partCount = getSnapshotPartCount(numTanks, numBullets);
+        Uint16 sequence = recordSnapshotSent(snapshots, getSnapshotSize(numTanks, numBullets), now);
+        out.address = connectedPlayers[i].address;
+        for (int part = 0; part < partCount; part++) {
+            out.len = encodeSnapshotPart(out.data, sequence, simulationTime, part, partCount, visibleTanks, numTanks, selected, numBullets);
+            queueOutbound(&out);
+        }
+    }
+}
+
+
+// Hela rummet kodas en gång per tick, oavsett hur många som tittar.
+// Utan fördröjning hoppas det över när ingen tittar; med fördröjning måste ringen fyllas i förväg.
+void publishSpectatorSnapshot(const TankState* liveTanks, int numTanks, const BulletState* activeBullets, int numBullets) {
+    if (spectatorDelayMs == 0 && SDL_AtomicGet(&numSpectators) == 0) return;
+    int partCount = getSnapshotPartCount(numTanks, numBullets);
+    if (partCount > SPECTATOR_FRAME_PARTS) return;
+    int lengths[SPECTATOR_FRAME_PARTS];
+    Uint16 sequence = spectatorSequence++;
+    // Stämplas med tiden då åskådarna får den, så att deras klocksynk inte ser den fördröjda strömmen som gammal
+    Uint32 shownAt = simulationTime + spectatorDelayMs;
+    for (int part = 0; part < partCount; part++) {
+        lengths[part] = encodeSnapshotPart(getSpectatorPartBuffer(spectatorFeed, part), sequence, shownAt, part, partCount,
+                                           liveTanks, numTanks, activeBullets, numBullets);
+    }
+    publishSpectatorFrame(spectatorFeed, lengths, partCount, simulationTime);
+}
+
+
+void fillTankState(int index, TankState* state) {
+    SDL_Rect rect = getTankRect(tanks[index]);
+    *state = (TankState){
+        .playerNumber = connectedPlayers[index].playerID,
+        .x = rect.x,
+        .y = rect.y,
+        .angle = getTankAngle(tanks[index]),
+        .tankColorId = getTankColorId(tanks[index]),
+        .health = getTankHealth(tanks[index]),
+        .shooting = false
+    };
+}
+
+
+// Närmaste kulorna först, så att det som snart kan träffa spelaren aldrig är det som stryks
+int selectBulletsFor(int index, const BulletState* all, int count, BulletState* out, int maxCount) {
+    if (count <= maxCount) {
+        memcpy(out, all, count * sizeof(BulletState));
+        return count;
+    }
+    SDL_Rect rect = getTankRect(tanks[index]);
+    float centerX = rect.x + rect.w / 2.0f;
+    float centerY = rect.y + rect.h / 2.0f;
+    // Bara de maxCount bästa hålls sorterade, så kostnaden växer med count * maxCount och inte count i kvadrat
+    float distance[MAX_ROOM_BULLETS];
+    int order[MAX_ROOM_BULLETS];
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        float dx = all[i].x - centerX;
+        float dy = all[i].y - centerY;
+        float d = dx * dx + dy * dy;
+        if (kept == maxCount && (maxCount == 0 || distance[kept - 1] <= d)) continue;
+        int j = kept < maxCount ? kept++ : kept - 1;
+        while (j > 0 && distance[j - 1] > d) {
+            distance[j] = distance[j - 1];
+            order[j] = order[j - 1];
+            j--;
         }
+        distance[j] = d;
+        order[j] = i;
+    }
+    for (int i = 0; i < kept; i++) {
+        out[i] = all[order[i]];
     }
+    return kept;
+}
+
+
+// Timern flyttas inte vid varje UPDATE; den kontrollerar lastHeartbeat först när den löper ut
+void onHeartbeatTimer(TimerEntry* entry, Uint32 now) {
+    int index = (int)(entry - heartbeatTimers);
+    if (connectedPlayers[index].active && !tanks[index]) {
+        connectedPlayers[index].active = false;
+        cancelTimer(&retransmitTimers[index]);
+        LOG_ASYNC("Plats %d släpptes, ingen anslutning slutfördes", index + 1);
+        return;
+    }
+    if (!playerStatus[index].active) return;
+    if (now - playerStatus[index].lastHeartbeat < HEARTBEAT_TIMEOUT_MS) {
+        scheduleTimer(&timers, entry, playerStatus[index].lastHeartbeat + HEARTBEAT_TIMEOUT_MS);
+        return;
+    }
+    disconnectPlayer(index);
+}
+
+
+void disconnectPlayer(int index) {
+    playerStatus[index].active = false;
+    connectedPlayers[index].active = false;
+    cancelTimer(&heartbeatTimers[index]);
+    cancelTimer(&retransmitTimers[index]);
+    tanks[index] = NULL;
+    numConnectedPlayers--;
+    LOG_ASYNC("Player %d disconnected due to timeout. Total players: %d", connectedPlayers[index].playerID, numConnectedPlayers);
+}
+
+
+void onSimulationTick(TimerEntry* entry, Uint32 now) {
+    TRACE_SCOPE("tick");
+    // Fast steg per tick, så att rörelsen inte beror på när huvudloopen senast vaknade av ett paket
+    simulationTime = now;
+    updateTanks(TICK_STEP_DT);
+    updateServerBullets(TICK_STEP_DT);
+    updateRoom(now);
+    // Världen samlas en gång per tick och delas av spelarnas snapshots och åskådarringen
+    TankState liveTanks[MAX_PLAYERS];
+    BulletState activeBullets[MAX_ROOM_BULLETS];
+    int numLiveTanks = gatherLiveTanks(liveTanks);
+    int numActiveBullets = gatherActiveBullets(activeBullets);
+    broadcastGameState(liveTanks, numLiveTanks, activeBullets, numActiveBullets);
+    publishSpectatorSnapshot(liveTanks, numLiveTanks, activeBullets, numActiveBullets);
+    scheduleTimer(&timers, entry, now + TICK_INTERVAL_MS);
 }
 
 
 void updateTanks(float dt) {
+    TRACE_SCOPE("updateTanks");
     for (int i = 0; i < MAX_PLAYERS; i++) {
         if (!connectedPlayers[i].active || !tanks[i]) continue;
-        if (getTankHealth(tanks[i]) <= 0) {
-            connectedPlayers[i].active = false;
-            playerStatus[i].active = false;
-            continue;
-    }
+        // Döda tankar står kvar och tittar på tills nästa runda
+        if (getTankHealth(tanks[i]) <= 0) continue;
+        if (roomPhase == ROOM_COUNTDOWN || roomPhase == ROOM_RESULTS) continue;
         float angle = playerStatus[i].angle;
         if (playerStatus[i].left && !playerStatus[i].right) {
             angle -= 10.0f;
@@ -298,8 +992,8 @@ void updateTanks(float dt) {
         rect.y += dy;
         if (rect.x < 0) rect.x = 0;
         if (rect.y < 0) rect.y = 0;
-        if (rect.x > WINDOW_WIDTH - rect.w) rect.x = WINDOW_WIDTH - rect.w;
-        if (rect.y > WINDOW_HEIGHT - rect.h) rect.y = WINDOW_HEIGHT - rect.h;
+        if (rect.x > worldWidth - rect.w) rect.x = worldWidth - rect.w;
+        if (rect.y > worldHeight - rect.h) rect.y = worldHeight - rect.h;
         if (!wallCheckCollision(topLeftWall, &rect) &&
             !wallCheckCollision(topRightWall, &rect) &&
             !wallCheckCollision(bottomLeftWall, &rect) &&
@@ -311,7 +1005,8 @@ void updateTanks(float dt) {
 
 
 void updateServerBullets(float dt) {
-    for (int i = 0; i < MAX_PLAYERS * MAX_BULLETS_PER_PLAYER; i++) {
+    TRACE_SCOPE("updateServerBullets");
+    for (int i = 0; i < MAX_ROOM_BULLETS; i++) {
         if (!bullets[i].active) continue;
         bullets[i].x += bullets[i].velocityX * dt;
         bullets[i].y += bullets[i].velocityY * dt;
@@ -335,37 +1030,181 @@ void updateServerBullets(float dt) {
             }
         }
         for (int j = 0; j < MAX_PLAYERS; j++) {
-            if (!connectedPlayers[j].active || !tanks[j]) continue;
+            if (!connectedPlayers[j].active || !tanks[j] || getTankHealth(tanks[j]) <= 0) continue;
             if (bullets[i].ownerId == connectedPlayers[j].playerID) continue;
             SDL_Rect tankRect = getTankRect(tanks[j]);
             if (checkCollision(&tankRect, &bullets[i].rect)) {
                 bullets[i].active = false;
-                int hp = getTankHealth(tanks[j]);
-                if (hp > 0) {
-                    setTankHealth(tanks[j], hp - 1);
+                if (roomPhase == ROOM_PLAYING) {
+                    setTankHealth(tanks[j], getTankHealth(tanks[j]) - 1);
+                    playerStatus[j].damageTaken++;
+                    if (getTankHealth(tanks[j]) <= 0) playerStatus[j].diedAt = simulationTime;
+                    int owner = bullets[i].ownerId - 1;
+                    if (owner >= 0 && owner < MAX_PLAYERS && connectedPlayers[owner].active) {
+                        playerStatus[owner].hits++;
+                    }
                 }
                 break;
             }
         }
-        if (bullets[i].x < 0 || bullets[i].x > WINDOW_WIDTH ||
-            bullets[i].y < 0 || bullets[i].y > WINDOW_HEIGHT) {
+        if (serverBulletOutOfBounds(&bullets[i], worldWidth, worldHeight)) {
             bullets[i].active = false;
         }
     }
-    int alivePlayers = countPlayersWithHealth();
-    if (maxConnectedPlayers > 1 && alivePlayers == 1 && matchStarted) {
-        for (int i = 0; i < MAX_PLAYERS; i++) {
-            if (connectedPlayers[i].active && tanks[i] && getTankHealth(tanks[i]) > 0) {
-                broadcastMatchOver(i + 1);
-                matchStarted = false; 
-                maxConnectedPlayers = 0;
-                break;
+}
+
+
+// Väggarna och tankpoolen ligger i matchArena och lever lika länge som rummet
+bool buildMatch() {
+    Wall* walls[MAP_WALL_COUNT];
+    if (!createMapWalls(matchArena, worldWidth, worldHeight, walls)) return false;
+    topLeftWall = walls[0];
+    topRightWall = walls[1];
+    bottomLeftWall = walls[2];
+    bottomRightWall = walls[3];
+    numSpawnPoints = createSpawnPoints(walls, worldWidth, worldHeight, TANK_SIZE, spawnPoints, roomSize);
+    if (numSpawnPoints < roomSize) {
+        SDL_Log("Kartan har bara %d startpositioner för %d platser, några delas", numSpawnPoints, roomSize);
+    }
+    return true;
+}
+
+
+// Plats i tar startposition i; finns det för få delar flera platser på samma
+void getSpawnPosition(int index, int* x, int* y) {
+    if (numSpawnPoints == 0) {
+        *x = (worldWidth - TANK_SIZE) / 2;
+        *y = (worldHeight - TANK_SIZE) / 2;
+        return;
+    }
+    *x = spawnPoints[index % numSpawnPoints].x;
+    *y = spawnPoints[index % numSpawnPoints].y;
+}
+
+
+// Nollställer tankar och kulor på plats; anslutningar, kanaler och tankobjekt behålls
+void resetRound(Uint32 now) {
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        if (!connectedPlayers[i].active || !tanks[i]) continue;
+        int x, y;
+        getSpawnPosition(i, &x, &y);
+        setTankPosition(tanks[i], x, y);
+        setTankAngle(tanks[i], 0);
+        setTankHealth(tanks[i], 3);
+        playerStatus[i].angle = 0;
+        playerStatus[i].lastShotTime = now - FIRE_COOLDOWN_MS;
+    }
+    for (int i = 0; i < MAX_ROOM_BULLETS; i++) {
+        bullets[i].active = false;
+    }
+}
+
+
+void updateRoom(Uint32 now) {
+    switch (roomPhase) {
+        case ROOM_LOBBY:
+            if (numConnectedPlayers >= MIN_ROUND_PLAYERS) setRoomPhase(ROOM_COUNTDOWN, 0, now);
+            break;
+        case ROOM_COUNTDOWN:
+            if (numConnectedPlayers < MIN_ROUND_PLAYERS) setRoomPhase(ROOM_LOBBY, 0, now);
+            break;
+        case ROOM_PLAYING:
+            if (countPlayersWithHealth() <= 1) {
+                int winner = 0;
+                for (int i = 0; i < MAX_PLAYERS; i++) {
+                    if (connectedPlayers[i].active && tanks[i] && getTankHealth(tanks[i]) > 0) {
+                        winner = connectedPlayers[i].playerID;
+                    }
+                }
+                SDL_Log("Round %d over, winner is Player %d", roundNumber, winner);
+                submitRoundStats(winner, now);
+                setRoomPhase(ROOM_RESULTS, winner, now);
             }
-        }
+            break;
+        case ROOM_RESULTS:
+            break;
+    }
+}
+
+
+void setRoomPhase(RoomPhase phase, int winningPlayerID, Uint32 now) {
+    roomPhase = phase;
+    lastWinner = winningPlayerID;
+    cancelTimer(&phaseTimer);
+    phaseEndsAt = now;
+    if (phase == ROOM_LOBBY || phase == ROOM_COUNTDOWN) {
+        resetRound(now);
+    }
+    if (phase == ROOM_COUNTDOWN || phase == ROOM_RESULTS) {
+        phaseEndsAt = now + (phase == ROOM_COUNTDOWN ? COUNTDOWN_MS : RESULTS_MS);
+        scheduleTimer(&timers, &phaseTimer, phaseEndsAt);
+    }
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        if (connectedPlayers[i].active && tanks[i]) sendRoomState(i, now);
+    }
+}
+
+
+void onPhaseTimer(TimerEntry* entry, Uint32 now) {
+    if (roomPhase == ROOM_COUNTDOWN) {
+        roundNumber++;
+        SDL_Log("Round %d started with %d players", roundNumber, numConnectedPlayers);
+        startRoundStats(now);
+        setRoomPhase(ROOM_PLAYING, 0, now);
+    } else if (roomPhase == ROOM_RESULTS) {
+        setRoomPhase(numConnectedPlayers >= MIN_ROUND_PLAYERS ? ROOM_COUNTDOWN : ROOM_LOBBY, 0, now);
+    }
+}
+
+
+// Bara de som lever när rundan startar räknas; den som ansluter senare väntar på nästa runda
+void startRoundStats(Uint32 now) {
+    roundStartedAt = now;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        PlayerStatus* status = &playerStatus[i];
+        status->inRound = connectedPlayers[i].active && tanks[i] && getTankHealth(tanks[i]) > 0;
+        status->shots = status->hits = status->damageTaken = 0;
+        status->diedAt = 0;
     }
 }
 
 
+// Simuleringstråden lämnar bara över resultatet; skrivning och fsync sker i statistiktråden
+void submitRoundStats(int winningPlayerID, Uint32 now) {
+    if (!statsWriter) return;
+    MatchResult result = {
+        .endedAt = (Sint64)time(NULL),
+        .round = roundNumber,
+        .durationMs = now - roundStartedAt,
+        .winningPlayerID = winningPlayerID
+    };
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        PlayerStatus* status = &playerStatus[i];
+        if (!connectedPlayers[i].active || !tanks[i] || !status->inRound) continue;
+        Uint32 endedAt = getTankHealth(tanks[i]) > 0 ? now : status->diedAt;
+        result.players[result.numPlayers++] = (PlayerResult){
+            .address = connectedPlayers[i].address,
+            .playerID = connectedPlayers[i].playerID,
+            .tankColorId = getTankColorId(tanks[i]),
+            .shots = status->shots,
+            .hits = status->hits,
+            .damageTaken = status->damageTaken,
+            .aliveMs = endedAt - roundStartedAt
+        };
+    }
+    if (!submitMatchResult(statsWriter, &result)) {
+        SDL_Log("Statistikkön är full, runda %d sparas inte", roundNumber);
+    }
+}
+
+
+void sendRoomState(int index, Uint32 now) {
+    RoomStateData state = { ROOM_STATE, roomPhase, roundNumber, lastWinner, 0 };
+    if ((Sint32)(phaseEndsAt - now) > 0) state.remainingMs = phaseEndsAt - now;
+    sendControl(index, &state, sizeof(RoomStateData), now);
+}
+
+
 int countPlayersWithHealth() {
     int aliveCount = 0;
     for (int i = 0; i < MAX_PLAYERS; i++) {
@@ -376,17 +1215,3 @@ int countPlayersWithHealth() {
     return aliveCount;
 }
 
-
-void broadcastMatchOver(int winningPlayerID) {
-    ServerData matchOverData;
-    matchOverData.command = MATCH_OVER;
-    matchOverData.winningPlayerID = winningPlayerID;
-    for (int i = 0; i < numConnectedPlayers; i++) {
-        if (!connectedPlayers[i].active) continue;
-        packet->address = connectedPlayers[i].address;
-        memcpy(packet->data, &matchOverData, sizeof(ServerData));
-        packet->len = sizeof(ServerData);
-        SDLNet_UDP_Send(serverSocket, -1, packet);
-    }
-    SDL_Log("Match over, winner is Player %d", winningPlayerID);
-}
\ No newline at end of file